@@ -0,0 +1,55 @@
+#!/bin/bash
+# cost of DD size bookkeeping on bell-11 and bell-12: a baseline binary whose Dd copy constructor still counts
+# nodes and leaves on every copy, against the current binary at --vl 1 (no counting) and --vl 2 (counting only at
+# the named checkpoints); counts must agree
+# usage: scripts/bench_checkpoints.sh baseline-binary [binary] [runs]
+# a baseline binary can be built from the commit before the checkpoints were introduced:
+#   git worktree add /tmp/pbcounter-base 6ee076c~1 && (cd /tmp/pbcounter-base && git submodule update --init && ./build.sh)
+
+BASE_BIN=$1
+BIN=${2:-./PBCounter}
+RUNS=${3:-3}
+INSTANCES=${INSTANCES:-"examples/bell/bell-11.ec.wpbf examples/bell/bell-12.ec.wpbf"}
+LIMIT=${LIMIT:-3600}
+
+for bin in "$BASE_BIN" "$BIN"; do
+    if [ ! -x "$bin" ]; then
+        echo "binary '$bin' not found; usage: $0 baseline-binary [binary] [runs]"
+        exit 1
+    fi
+done
+
+# prints "<seconds> <count>" of one run, or nothing if it did not finish
+run() {
+    timeout "$LIMIT" "$1" --if "$2" --vl "$3" 2>/dev/null |
+        awk '$2 == "seconds" { secs = $3 } $1 == "s" { count = $NF } END { if (secs != "" && count != "") print secs, count }'
+}
+
+STATUS=0
+for instance in $INSTANCES; do
+    echo "$(basename "$instance")"
+    for config in "baseline --vl 1:$BASE_BIN:1" "current --vl 1:$BIN:1" "current --vl 2:$BIN:2"; do
+        IFS=: read -r label bin verbosity <<< "$config"
+        BEST=""
+        for r in $(seq "$RUNS"); do
+            read -r secs count <<< "$(run "$bin" "$instance" "$verbosity")"
+            if [ -z "$secs" ]; then
+                continue
+            fi
+            if [ -z "$EXPECTED" ]; then
+                EXPECTED=$count
+            elif [ "$count" != "$EXPECTED" ]; then
+                echo "  $label: count $count differs from $EXPECTED"
+                STATUS=1
+            fi
+            BEST=$(awk -v a="$BEST" -v b="$secs" 'BEGIN { print (a == "" || b < a) ? b : a }')
+        done
+        if [ -z "$BEST" ]; then
+            printf "  %-16s no run finished within %s seconds\n" "$label" "$LIMIT"
+        else
+            printf "  %-16s best of %d: %s s\n" "$label" "$RUNS" "$BEST"
+        fi
+    done
+    EXPECTED=""
+done
+exit $STATUS
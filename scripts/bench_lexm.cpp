@@ -0,0 +1,260 @@
+/* compares the LEXM ordering of Graph::getLexmOrdering with the one of the code it replaced, on the Gaifman graphs of
+ * the given wpbf files, and times both
+ * build: ./build.sh, then make -C .build benchLexm
+ * usage: .build/benchLexm [seconds] file.wpbf...
+ * the old code and the reference each get at most the given seconds (default 60) per file and are stopped between two
+ * numbers */
+
+/* inclusions *****************************************************************/
+
+#include "../src/interface/graph.hpp"
+
+/* old ordering ***************************************************************/
+
+// Pbf::getLexmVarOrdering and the Graph class it used, as they were before the rewrite, plus the deadline
+
+namespace old {
+
+struct PbLabel : vector<Int> {
+  void addNumber(Int i) {
+    push_back(i);
+    std::sort(begin(), end(), std::greater<Int>());
+  }
+};
+
+class Graph {
+  Set<Int> vertices;
+  Map<Int, Set<Int>> adjacencyMap;
+
+public:
+  Graph(const Set<Int> &vars) {
+    vertices = vars;
+    for (Int var : vars) adjacencyMap[var] = Set<Int>();
+  }
+
+  void addEdge(Int var1, Int var2) {
+    adjacencyMap.at(var1).insert(var2);
+    adjacencyMap.at(var2).insert(var1);
+  }
+
+  void removeVertex(Int v) {
+    vertices.erase(v);
+    adjacencyMap.erase(v);
+    for (std::pair<const Int, Set<Int>> &vertexAndNeighbors : adjacencyMap) vertexAndNeighbors.second.erase(v);
+  }
+
+  bool hasPath(Int from, Int to, Set<Int> &visitedVertices) const {
+    if (from == to) return true;
+    visitedVertices.insert(from);
+    Set<Int> unvisitedNeighbors;
+    util::differ(unvisitedNeighbors, adjacencyMap.at(from), visitedVertices);
+    for (Int v : unvisitedNeighbors) if (hasPath(v, to, visitedVertices)) return true;
+    return false;
+  }
+
+  bool hasPath(Int from, Int to) const {
+    Set<Int> visitedVertices;
+    return hasPath(from, to, visitedVertices);
+  }
+};
+
+Graph getGaifmanGraph(const vector<Int> &apparentVars, const vector<vector<Int>> &cliques) {
+  Set<Int> vars(apparentVars.begin(), apparentVars.end());
+  Graph graph(vars);
+  for (const vector<Int> &clique : cliques)
+    for (auto var1 = clique.begin(); var1 != clique.end(); var1++)
+      for (auto var2 = std::next(var1); var2 != clique.end(); var2++) graph.addEdge(*var1, *var2);
+  return graph;
+}
+
+// returns false if the deadline passed first
+bool getLexmVarOrdering(const vector<Int> &apparentVars, const vector<vector<Int>> &cliques, double deadline, vector<Int> &numberedVertices) {
+  TimePoint startTime = util::getTimePoint();
+  Map<Int, PbLabel> unnumberedVertices;
+  for (Int vertex : apparentVars) unnumberedVertices[vertex] = PbLabel();
+  for (Int i = apparentVars.size(); i > 0; i--) {
+    if (util::getSeconds(startTime) > deadline) return false;
+    auto vIt = std::max_element(unnumberedVertices.begin(), unnumberedVertices.end(), util::isLessValued<Int, PbLabel>);
+    Int v = vIt->first;
+    numberedVertices.push_back(v);
+    unnumberedVertices.erase(v);
+
+    Graph subgraph = getGaifmanGraph(apparentVars, cliques);
+    for (auto wIt = unnumberedVertices.begin(); wIt != unnumberedVertices.end(); wIt++) {
+      Int w = wIt->first;
+      PbLabel &wLabel = wIt->second;
+      for (Int numberedVertex : numberedVertices)
+        if (numberedVertex != v) subgraph.removeVertex(numberedVertex);
+      for (const std::pair<Int, PbLabel> &kv : unnumberedVertices) {
+        Int unnumberedVertex = kv.first;
+        const PbLabel &label = kv.second;
+        if (unnumberedVertex != w && label >= wLabel) subgraph.removeVertex(unnumberedVertex);
+      }
+      if (subgraph.hasPath(v, w)) wLabel.addNumber(i);
+    }
+  }
+  return true;
+}
+
+} // namespace old
+
+/* reference ordering *********************************************************/
+
+// LEXM straight from its definition, with the tie-break of Graph::getLexmOrdering (smallest id among the max labels):
+// after numbering v with i, i joins the label of each unnumbered w that v reaches through unnumbered vertices whose
+// labels, all taken before this step, are less than the label of w
+// if ordering is not empty, its vars are numbered in its order instead; returns the position of the first one that did
+// not have a max label (0 if none), or -1 if the deadline passed first
+static Int runReferenceLexm(const Graph &graph, double deadline, vector<Int> &ordering) {
+  TimePoint startTime = util::getTimePoint();
+  bool following = !ordering.empty();
+  Int vertexCount = graph.getVertexCount();
+  vector<old::PbLabel> labels(vertexCount);
+  vector<bool> numbered(vertexCount, false);
+  Int firstViolation = 0;
+  for (Int i = vertexCount; i > 0; i--) {
+    if (util::getSeconds(startTime) > deadline) return -1;
+    Int v = -1;
+    for (Int u = 0; u < vertexCount; u++) {
+      if (!numbered[u] && (v < 0 || labels[v] < labels[u])) v = u;
+    }
+    Int position = vertexCount - i;
+    if (following) {
+      Int u = graph.getVertexId(ordering[position]);
+      if (firstViolation == 0 && labels[u] < labels[v]) firstViolation = position + 1;
+      v = u;
+    } else {
+      ordering.push_back(graph.getVertex(v));
+    }
+    numbered[v] = true;
+
+    vector<Int> reachedIds;
+    for (Int w = 0; w < vertexCount; w++) {
+      if (numbered[w]) continue;
+      vector<bool> visited(vertexCount, false);
+      vector<Int> stack = {v};
+      visited[v] = true;
+      bool found = false;
+      while (!stack.empty() && !found) {
+        Int u = stack.back();
+        stack.pop_back();
+        for (auto n = graph.beginNeighbors(u); n != graph.endNeighbors(u); n++) {
+          if (*n == w) {
+            found = true;
+            break;
+          }
+          if (!numbered[*n] && !visited[*n] && labels[*n] < labels[w]) {
+            visited[*n] = true;
+            stack.push_back(*n);
+          }
+        }
+      }
+      if (found) reachedIds.push_back(w);
+    }
+    for (Int w : reachedIds) labels[w].addNumber(i);
+  }
+  return firstViolation;
+}
+
+/* comparison *****************************************************************/
+
+// fill edges added by eliminating vars in increasing alpha number, so from the back of the numbering order; an LEXM
+// ordering adds an inclusion-minimal set of them
+static Int getFillCount(const Graph &graph, const vector<Int> &ordering) {
+  vector<Set<Int>> adjacencySets(graph.getVertexCount());
+  for (Int v = 0; v < graph.getVertexCount(); v++) adjacencySets[v].insert(graph.beginNeighbors(v), graph.endNeighbors(v));
+  Int fillCount = 0;
+  for (auto var = ordering.rbegin(); var != ordering.rend(); var++) {
+    Int v = graph.getVertexId(*var);
+    for (Int n1 : adjacencySets[v]) {
+      adjacencySets[n1].erase(v);
+      for (Int n2 : adjacencySets[v]) {
+        if (n1 < n2 && adjacencySets[n1].insert(n2).second) {
+          adjacencySets[n2].insert(n1);
+          fillCount++;
+        }
+      }
+    }
+    adjacencySets[v].clear();
+  }
+  return fillCount;
+}
+
+static Int getInducedWidth(const Graph &graph, const vector<Int> &ordering) {
+  return graph.getInducedWidth(vector<Int>(ordering.rbegin(), ordering.rend()));
+}
+
+static string describe(const Graph &graph, vector<Int> &ordering, const vector<Int> &newOrdering, double deadline) {
+  Int firstDifference = std::mismatch(ordering.begin(), ordering.end(), newOrdering.begin()).first - ordering.begin();
+  std::ostringstream description;
+  if (firstDifference == ordering.size()) {
+    description << "same as new";
+  } else {
+    description << "differs from position " << firstDifference + 1;
+    Int firstViolation = runReferenceLexm(graph, deadline, ordering);
+    if (firstViolation == 0) description << " by ties only";
+    else if (firstViolation > 0) description << ", not LEXM from position " << firstViolation;
+  }
+  description << ", fill " << getFillCount(graph, ordering) << ", width " << getInducedWidth(graph, ordering);
+  return description.str();
+}
+
+// the vars of each constraint line, in order of first appearance as Pbf::updateApparentVars collects them
+static void readCliques(const string &filePath, vector<Int> &apparentVars, vector<vector<Int>> &cliques) {
+  std::ifstream inputFileStream(filePath);
+  if (!inputFileStream.is_open()) showError("unable to open file '" + filePath + "'");
+  Set<Int> seenVars;
+  string line;
+  while (std::getline(inputFileStream, line)) {
+    if (line.empty() || line[0] == '*' || line[0] == 'w') continue;
+    std::istringstream lineStream(line);
+    vector<Int> clique;
+    string word;
+    while (lineStream >> word) {
+      size_t x = word.find('x');
+      if (x == string::npos) continue;
+      Int var = std::abs(std::stoll(word.substr(x + 1)));
+      if (seenVars.insert(var).second) apparentVars.push_back(var);
+      if (!util::isFound(var, clique)) clique.push_back(var);
+    }
+    if (!clique.empty()) cliques.push_back(clique);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  double deadline = 60;
+  int firstFile = 1;
+  if (argc > 1 && std::isdigit(argv[1][0])) {
+    deadline = std::stod(argv[1]);
+    firstFile = 2;
+  }
+
+  for (int fileIndex = firstFile; fileIndex < argc; fileIndex++) {
+    vector<Int> apparentVars;
+    vector<vector<Int>> cliques;
+    readCliques(argv[fileIndex], apparentVars, cliques);
+    Graph graph(apparentVars, cliques);
+    cout << argv[fileIndex] << ": " << apparentVars.size() << " vars\n";
+
+    TimePoint startTime = util::getTimePoint();
+    vector<Int> newOrdering = graph.getLexmOrdering();
+    cout << "\tnew       " << util::getSeconds(startTime) << " s, fill " << getFillCount(graph, newOrdering) << ", width " << getInducedWidth(graph, newOrdering) << "\n";
+
+    startTime = util::getTimePoint();
+    vector<Int> referenceOrdering;
+    if (runReferenceLexm(graph, deadline, referenceOrdering) == 0) {
+      cout << "\treference " << util::getSeconds(startTime) << " s, " << describe(graph, referenceOrdering, newOrdering, deadline) << "\n";
+    } else {
+      cout << "\treference stopped after " << deadline << " s at " << referenceOrdering.size() << " of " << apparentVars.size() << " numbers\n";
+    }
+
+    startTime = util::getTimePoint();
+    vector<Int> oldOrdering;
+    if (old::getLexmVarOrdering(apparentVars, cliques, deadline, oldOrdering)) {
+      cout << "\told       " << util::getSeconds(startTime) << " s, " << describe(graph, oldOrdering, newOrdering, deadline) << "\n";
+    } else {
+      cout << "\told       stopped after " << deadline << " s at " << oldOrdering.size() << " of " << apparentVars.size() << " numbers\n";
+    }
+    cout.flush();
+  }
+}
@@ -0,0 +1,32 @@
+#!/bin/bash
+# parser throughput in MB/s on the bell instances concatenated COPIES times
+# usage: scripts/bench_parser.sh [binary] [copies] [runs]
+# the combined formula is not meant to be counted: each run is stopped LIMIT seconds after it starts,
+# and the throughput is taken from the parseSeconds row printed right after parsing
+
+BIN=${1:-./PBCounter}
+COPIES=${2:-100}
+RUNS=${3:-3}
+LIMIT=${LIMIT:-30}
+
+if [ ! -x "$BIN" ]; then
+    echo "binary '$BIN' not found; run ./build.sh first"
+    exit 1
+fi
+
+INPUT=$(mktemp --suffix=.wpbf)
+trap 'rm -f "$INPUT"' EXIT
+for i in $(seq "$COPIES"); do
+    cat examples/bell/*.wpbf >> "$INPUT"
+done
+MEGABYTES=$(awk -v bytes="$(stat -c %s "$INPUT")" 'BEGIN { print bytes / 1e6 }')
+
+echo "input: $COPIES copies of examples/bell, $MEGABYTES MB"
+for run in $(seq "$RUNS"); do
+    SECS=$(timeout "$LIMIT" stdbuf -oL "$BIN" --if "$INPUT" --vl 1 2>/dev/null | awk '$2 == "parseSeconds" { print $3; exit }')
+    if [ -z "$SECS" ]; then
+        echo "run $run: no parseSeconds within $LIMIT seconds"
+    else
+        awk -v run="$run" -v mb="$MEGABYTES" -v secs="$SECS" 'BEGIN { printf "run %d: %.3f s, %.1f MB/s\n", run, secs, mb / secs }'
+    fi
+done
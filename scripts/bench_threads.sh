@@ -0,0 +1,54 @@
+#!/bin/bash
+# --tc scaling on examples/bell and examples/s5t2: seconds per instance at 1, 2, 4, 8 and 16 workers,
+# the speedup over 1 worker, and a check that every worker count prints the same count
+# usage: scripts/bench_threads.sh [binary] [instance...]
+# a run still going LIMIT seconds after it starts is stopped and shown as "-"
+
+BIN=${1:-./PBCounter}
+shift
+INSTANCES=("$@")
+if [ ${#INSTANCES[@]} -eq 0 ]; then
+    INSTANCES=(examples/bell/*.wpbf examples/s5t2/*.wpbf)
+fi
+THREADS=${THREADS:-"1 2 4 8 16"}
+LIMIT=${LIMIT:-600}
+
+if [ ! -x "$BIN" ]; then
+    echo "binary '$BIN' not found; run ./build.sh first"
+    exit 1
+fi
+
+printf "%-24s" "instance"
+for tc in $THREADS; do printf "%14s" "tc=$tc"; done
+printf "  counts\n"
+
+MISMATCHES=0
+for instance in "${INSTANCES[@]}"; do
+    printf "%-24s" "$(basename "$instance")"
+    BASE=""
+    FIRST_COUNT=""
+    AGREE=yes
+    for tc in $THREADS; do
+        OUTPUT=$(timeout "$LIMIT" "$BIN" --if "$instance" --tc "$tc" --vl 1 2>/dev/null)
+        SECS=$(awk '$2 == "seconds" { print $3 }' <<< "$OUTPUT")
+        COUNT=$(awk '$1 == "s" { print $NF }' <<< "$OUTPUT")
+        if [ -z "$SECS" ] || [ -z "$COUNT" ]; then
+            printf "%14s" "-"
+            continue
+        fi
+        if [ -z "$BASE" ]; then
+            BASE=$SECS
+            FIRST_COUNT=$COUNT
+        elif [ "$COUNT" != "$FIRST_COUNT" ]; then
+            AGREE="NO ($FIRST_COUNT vs $COUNT at tc=$tc)"
+            MISMATCHES=$((MISMATCHES + 1))
+        fi
+        printf "%14s" "$(awk -v secs="$SECS" -v base="$BASE" 'BEGIN { printf "%.2fs x%.2f", secs, base / secs }')"
+    done
+    printf "  %s\n" "$AGREE"
+done
+
+if [ "$MISMATCHES" -ne 0 ]; then
+    echo "$MISMATCHES runs disagree with the count of the fewest workers"
+    exit 1
+fi
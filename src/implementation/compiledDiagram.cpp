@@ -0,0 +1,202 @@
+/* inclusions *****************************************************************/
+
+#include <fstream>
+#include <iterator>
+
+#include "../interface/compiledDiagram.hpp"
+
+/* uses ***********************************************************************/
+
+using util::printComment;
+using util::showError;
+
+/* constants ******************************************************************/
+
+// "p diagram <level count> <node count>", "l <cnf var of each level> 0", "s <var> <literal>" per substitution,
+// "n <high id> <low id> <cnf var>" per node (ids 0 and 1 are the leaves, node ids count up from 2), "r <root id>"
+static const string& DIAGRAM_COMMENT_WORD = "c";
+static const string& DIAGRAM_WORD = "diagram";
+static const string& LEVEL_WORD = "l";
+static const string& SUBSTITUTION_WORD = "s";
+static const string& NODE_WORD = "n";
+static const string& ROOT_WORD = "r";
+
+/* helpers ********************************************************************/
+
+static mpq_class getQuotient(const Number& n) {
+    return n.quotient;
+}
+
+static long double getLongDouble(const Number& n) {  // the product of the weight sums may leave the double range before the values shrink it
+    return n.fraction;
+}
+
+/* class CompiledDiagram ******************************************************/
+
+CompiledDiagram::CompiledDiagram(const Dd& dd, const vector<Int>& ddVarToCnfVarMap, const vector<Pair<Int, Int>>& substitutions, const Cudd& mgr) {
+    levelVars = ddVarToCnfVarMap;
+    this->substitutions = substitutions;
+    rootId = dd.getDecisionNodes(nodeLevels, highIds, lowIds, mgr);  // dd vars are levels, as the counters never reorder
+}
+
+CompiledDiagram::CompiledDiagram(const string& filePath) {
+    printComment("Reading compiled diagram...", 1);
+
+    std::ifstream inputFileStream(filePath);
+    if (!inputFileStream.is_open()) showError("unable to open compiled diagram '" + filePath + "'");
+
+    Map<Int, Int> cnfVarToLevel;
+    Int declaredNodeCount = DUMMY_MIN_INT;
+    rootId = DUMMY_MIN_INT;
+    Int lineIndex = 0;
+    string line;
+    while (std::getline(inputFileStream, line)) {
+        lineIndex++;
+        std::istringstream inputStringStream(line);
+        vector<string> words;
+        std::copy(std::istream_iterator<string>(inputStringStream), std::istream_iterator<string>(), std::back_inserter(words));
+
+        Int wordCount = words.size();
+        if (wordCount < 1) continue;
+        const string& startWord = words.at(0);
+        auto getInt = [&words, lineIndex](Int i) { return util::parseInt(words.at(i), lineIndex); };
+
+        if (startWord == DIAGRAM_COMMENT_WORD) {
+            continue;
+        } else if (startWord == PROBLEM_WORD) {
+            if (wordCount != 4 || words.at(1) != DIAGRAM_WORD) showError("expected 'p " + DIAGRAM_WORD + " <levels> <nodes>' -- line " + to_string(lineIndex));
+            declaredNodeCount = getInt(3);
+        } else if (startWord == LEVEL_WORD) {
+            for (Int i = 1; i < wordCount && getInt(i) != 0; i++) {
+                cnfVarToLevel[getInt(i)] = levelVars.size();
+                levelVars.push_back(getInt(i));
+            }
+        } else if (startWord == SUBSTITUTION_WORD && wordCount == 3) {
+            substitutions.push_back({getInt(1), getInt(2)});
+        } else if (startWord == NODE_WORD && wordCount == 4) {
+            Int nodeId = nodeLevels.size() + 2;
+            Int highId = getInt(1), lowId = getInt(2);
+            if (highId < 0 || highId >= nodeId || lowId < 0 || lowId >= nodeId) {
+                showError("node " + to_string(nodeId) + " has a child that is not listed before it -- line " + to_string(lineIndex));
+            }
+            auto it = cnfVarToLevel.find(getInt(3));
+            if (it == cnfVarToLevel.end()) showError("var " + words.at(3) + " has no level -- line " + to_string(lineIndex));
+            nodeLevels.push_back(it->second);
+            highIds.push_back(highId);
+            lowIds.push_back(lowId);
+        } else if (startWord == ROOT_WORD && wordCount == 2) {
+            rootId = getInt(1);
+        } else {
+            showError("unexpected line in compiled diagram -- line " + to_string(lineIndex));
+        }
+    }
+
+    if (declaredNodeCount != getNodeCount()) {
+        showError("compiled diagram declares " + to_string(declaredNodeCount) + " nodes but lists " + to_string(getNodeCount()));
+    }
+    if (rootId < 0 || rootId >= getNodeCount() + 2) showError("compiled diagram has no root");
+    for (Int i = 0; i < getNodeCount(); i++) {  // a child must lie below its parent
+        for (Int childId : {highIds[i], lowIds[i]}) {
+            if (childId >= 2 && nodeLevels[childId - 2] <= nodeLevels[i]) showError("node " + to_string(i + 2) + " is not above its children");
+        }
+    }
+}
+
+Int CompiledDiagram::getNodeCount() const {
+    return nodeLevels.size();
+}
+
+const vector<Pair<Int, Int>>& CompiledDiagram::getSubstitutions() const {
+    return substitutions;
+}
+
+void CompiledDiagram::write(const string& filePath) const {
+    std::ofstream outputFileStream(filePath);
+    if (!outputFileStream.is_open()) showError("unable to write compiled diagram '" + filePath + "'");
+
+    outputFileStream << DIAGRAM_COMMENT_WORD << " weight-free diagram compiled by PBCounter; evaluate it with --" << EVALUATE_FILE_OPTION << "\n";
+    outputFileStream << PROBLEM_WORD << " " << DIAGRAM_WORD << " " << levelVars.size() << " " << getNodeCount() << "\n";
+    outputFileStream << LEVEL_WORD;
+    for (Int cnfVar : levelVars) outputFileStream << " " << cnfVar;
+    outputFileStream << " 0\n";
+    for (const Pair<Int, Int>& substitution : substitutions) {
+        outputFileStream << SUBSTITUTION_WORD << " " << substitution.first << " " << substitution.second << "\n";
+    }
+    for (Int i = 0; i < getNodeCount(); i++) {
+        outputFileStream << NODE_WORD << " " << highIds[i] << " " << lowIds[i] << " " << levelVars.at(nodeLevels[i]) << "\n";
+    }
+    outputFileStream << ROOT_WORD << " " << rootId << "\n";
+    if (!outputFileStream.good()) showError("unable to write compiled diagram '" + filePath + "'");
+}
+
+// value(node) = w(-x) * value(low) * skip(low) + w(x) * value(high) * skip(high), where skip multiplies w(y) + w(-y)
+// over the levels of the vars y the edge jumps over; dividing the weights of each var by their nonzero sum turns
+// every such factor into 1, so a node costs O(1) whatever its edges skip, and the sums are multiplied back once
+// at the root; an edge that skips a var whose weights sum to 0 contributes 0
+template <typename T>
+T CompiledDiagram::evaluate(const Map<Int, Number>& literalWeights, T (*getValue)(const Number&)) const {
+    Int levelCount = levelVars.size();
+    vector<T> positiveWeights(levelCount), negativeWeights(levelCount);  // normalized unless the sum is 0
+    vector<Int> prefixZeros(levelCount + 1, 0);  // levels [0, l) with a zero weight sum
+    T weightSumProduct = 1;  // of the nonzero sums
+    for (Int level = 0; level < levelCount; level++) {
+        Int cnfVar = levelVars[level];
+        positiveWeights[level] = getValue(literalWeights.at(cnfVar));
+        negativeWeights[level] = getValue(literalWeights.at(-cnfVar));
+        T weightSum = positiveWeights[level] + negativeWeights[level];
+        prefixZeros[level + 1] = prefixZeros[level] + (weightSum == 0);
+        if (weightSum != 0) {
+            positiveWeights[level] /= weightSum;
+            negativeWeights[level] /= weightSum;
+            weightSumProduct *= weightSum;
+        }
+    }
+
+    vector<T> values(getNodeCount() + 2, T(0));
+    values[1] = T(1);
+    auto getLevel = [&](Int id) { return id < 2 ? levelCount : nodeLevels[id - 2]; };
+    auto getSkippedValue = [&](Int id, Int fromLevel) {  // value of id seen from fromLevel <= its level
+        return prefixZeros[getLevel(id)] > prefixZeros[fromLevel] ? T(0) : values[id];
+    };
+    for (Int i = 0; i < getNodeCount(); i++) {
+        Int level = nodeLevels[i];
+        values[i + 2] = positiveWeights[level] * getSkippedValue(highIds[i], level + 1) + negativeWeights[level] * getSkippedValue(lowIds[i], level + 1);
+    }
+    T modelCount = getSkippedValue(rootId, 0) * weightSumProduct;
+
+    Set<Int> levelVarSet(levelVars.begin(), levelVars.end());  // vars outside the diagram's order, as in util::adjustModelCount
+    for (Int cnfVar = 1; cnfVar <= Int(literalWeights.size()) / 2; cnfVar++) {
+        if (levelVarSet.count(cnfVar) == 0) modelCount *= getValue(literalWeights.at(cnfVar) + literalWeights.at(-cnfVar));
+    }
+    return modelCount;
+}
+
+Number CompiledDiagram::evaluate(const Map<Int, Number>& literalWeights) const {
+    if (multiplePrecision) return Number(evaluate<mpq_class>(literalWeights, getQuotient));
+    return Number(Float(evaluate<long double>(literalWeights, getLongDouble)));
+}
+
+void CompiledDiagram::evaluateFile(const string& diagramFilePath, const string& inputFilePath, WeightFormat weightFormat) {
+    CompiledDiagram diagram(diagramFilePath);
+    if (verbosityLevel >= 1) {
+        util::printRow("compiledLevels", diagram.levelVars.size());
+        util::printRow("compiledNodes", diagram.getNodeCount());
+    }
+
+    Pbf pbf(inputFilePath, weightFormat);  // only its weights are used
+    for (const Pair<Int, Int>& substitution : diagram.getSubstitutions()) {
+        if (!pbf.substituteVar(substitution.first, substitution.second)) {
+            showError("input has no weights for substitution of var " + to_string(substitution.first) + " by " + to_string(substitution.second));
+        }
+    }
+
+    printComment("Evaluating compiled diagram...", 1);
+    TimePoint evaluationStartTime = util::getTimePoint();
+    vector<Number> modelCounts;
+    for (Int lane = 0; lane < pbf.getLaneCount(); lane++) modelCounts.push_back(diagram.evaluate(pbf.getLaneWeights(lane)));
+    if (verbosityLevel >= 1) util::printRow("evaluationSeconds", util::getSeconds(evaluationStartTime));
+
+    for (Int lane = 0; lane < modelCounts.size(); lane++) {
+        util::printSolutionLine(modelCounts[lane], weightFormat, lane == 0, lane + 1 == modelCounts.size());
+    }
+}
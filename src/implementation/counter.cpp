@@ -1,5 +1,18 @@
+#include <sys/prctl.h>
+#include <sys/wait.h>
+
+#include <csignal>
+#include <cstdio>
+
 #include "../interface/counter.hpp"
 
+/* Lace tasks *****************************************************************/
+
+// counts one child of a join node, so that independent subtrees run on different workers
+VOID_TASK_5(countSubtreeTask, Counter*, counter, JoinNode*, joinNode, const Pbf*, pbf, Set<Int>*, projectedCnfVars, Dd*, dd) {
+    *dd = counter->countSubtree(joinNode, *pbf, *projectedCnfVars);
+}
+
 Float diagram::getTerminalValue(const ADD& terminal) {
     DdNode* node = terminal.getNode();
     return (node->type).value;
@@ -45,6 +58,10 @@ void Counter::handleSignals(int signal) {
     showError("received system signal " + to_string(signal) + "; printed dummy model count");
 }
 
+bool Counter::countingInParallel() {
+    return ddPackage == SYLVAN_PACKAGE && threadCount != 1;
+}
+
 void Counter::writeDotFile(Dd& dd, const string& dotFileDir) {
     dd.writeDotFile(mgr, dotFileDir);
 }
@@ -74,88 +91,7 @@ void Counter::printCnfToDdVarMap() const {
     }
 }
 
-Dd Counter::constructDd(const vector<Pair<Int, Pair<Int, Int> > >& clausePbfVarOrder,
-                         vector<Mymap<Pair<Int, Int>, Int, HashFunc, EqualKey>>& itervalToDdIndex,
-                         vector<Dd>& structedDd,
-                         const Int& index,
-                         Int& lf,
-                         Int& rt,
-                         const Int& limit) const {
-    for (auto p : itervalToDdIndex[index]) {
-        if (p.first.first <= limit && limit <= p.first.second) {
-            lf = p.first.first;
-            // rt = p.first.first;
-            rt = p.first.second;            // fix a bug?
-            return structedDd[p.second];
-        }
-    }
-    Int literal = clausePbfVarOrder[index].second.first;
-    Int cnfVar = util::getCnfVar(literal);
-    Int varCoef = clausePbfVarOrder[index].second.second;
-    Int ddVar = clausePbfVarOrder[index].first;
-    Int tlf, trt, flf, frt;
-    Dd Bf = constructDd(clausePbfVarOrder, itervalToDdIndex, structedDd, index + 1, flf, frt, limit);
-    Dd Bt = constructDd(clausePbfVarOrder, itervalToDdIndex, structedDd, index + 1, tlf, trt, limit - varCoef);
-    Dd B  = Dd::getOneDd(mgr);
-
-    if (tlf == flf && trt == frt) {
-        B = Bt, lf = tlf + varCoef, rt = trt;
-    } else {
-        if (util::isPositiveLiteral(literal)) {
-            B = Dd::getVarDd(ddVar, mgr).getIte(Bt, Bf);
-        } else {
-            B = Dd::getVarDd(ddVar, mgr).getIte(Bf, Bt);
-        }
-        lf = std::max(flf, tlf + varCoef);
-        rt = std::min(frt, trt + varCoef);
-    }
-    structedDd.push_back(B);
-    itervalToDdIndex[index][{lf, rt}] = structedDd.size() - 1;
-    return B;
-}
-
-Dd Counter::constructDdEq(const vector<Pair<Int, Pair<Int, Int> > >& clausePbfVarOrder,
-                         vector<Map<Int, Int> >& valueToDdIndex,
-                         vector<Dd>& structedDd,
-                         const Int& sufCoefSum,
-                         const Int& index,
-                         const Int& limit) const {
-
-    if (valueToDdIndex[index].count(limit)) {
-        return structedDd[valueToDdIndex[index][limit]];
-    } else if (limit < 0) {             // UNSAT
-        return Dd::getZeroDd(mgr);
-    } else if (limit > sufCoefSum) {    // UNSAT
-        return Dd::getZeroDd(mgr);
-    }
-
-    Int literal = clausePbfVarOrder[index].second.first;
-    Int cnfVar = util::getCnfVar(literal);
-    Int varCoef = clausePbfVarOrder[index].second.second;
-    Int ddVar = clausePbfVarOrder[index].first;
-    
-    Dd Bf = constructDdEq(clausePbfVarOrder, valueToDdIndex, structedDd, 
-                            sufCoefSum - varCoef, index + 1, limit);
-    Dd Bt = constructDdEq(clausePbfVarOrder, valueToDdIndex, structedDd, 
-                            sufCoefSum - varCoef, index + 1, limit - varCoef);
-    Dd B  = Dd::getOneDd(mgr);
-
-
-    if (util::isPositiveLiteral(literal)) {
-        B = Dd::getVarDd(ddVar, mgr).getIte(Bt, Bf);
-    } else {
-        B = Dd::getVarDd(ddVar, mgr).getIte(Bf, Bt);
-    }
-        
-    structedDd.push_back(B);
-    valueToDdIndex[index][limit] = structedDd.size() - 1;
-    return B;
-}
-
-
-//  这里需要对出现的 var 进行 cnf 序的重新排列，然后按照 order 来构建 BDD
-Dd Counter::getConstraintDd(const vector<Int>& clause, const vector<Int>& coefficient, const string& option, const Int& limit) const {
-    Int clauseVarSize = clause.size();
+Dd Counter::getConstraintDd(Span<Int> clause, Span<Int> coefficient, PbRelation relation, Int limit) const {
     vector<Pair<Int, Pair<Int, Int> > > clausePbfVarOrder;
     for (Int i = 0; i < clause.size(); i++) {
         Int literal = clause[i];
@@ -164,68 +100,119 @@ Dd Counter::getConstraintDd(const vector<Int>& clause, const vector<Int>& coeffi
         clausePbfVarOrder.push_back({cnfVarToDdVarMap.at(var), {literal, coef}});
     }
 
-    std::sort(clausePbfVarOrder.begin(), clausePbfVarOrder.end());  // <ddVar, cnfVar>
-
-    if(option == LEQUAL_WORD) {
-        vector<Mymap<Pair<Int, Int>, Int, HashFunc, EqualKey> > itervalToDdIndex(clauseVarSize + 1);
-        vector<Dd> structedDd;
+    Dd constraintDd = PbDdBuilder(clausePbfVarOrder, mgr).getDd(relation, limit);
+    constraintDd.recordCounts("constraint");
+    return constraintDd;
+}
 
-        structedDd.push_back(Dd::getZeroDd(mgr));  // false
-        structedDd.push_back(Dd::getOneDd(mgr));   // true
+Dd Counter::getConstraintDd(const PbConstraintStore& constraints, Int constraintIndex) const {
+    return getConstraintDd(constraints.getLiterals(constraintIndex), constraints.getCoefficients(constraintIndex), constraints.getRelation(constraintIndex), constraints.getLimit(constraintIndex));
+}
 
-        Int coefficientSum = 0;
-        for (int i = clauseVarSize - 1; i >= 0; i--) {
-            // coefficientSum += clausePbfVarOrder[i].second.second;
-            coefficientSum += clausePbfVarOrder[i].second.second;
-            itervalToDdIndex[i][{DUMMY_MIN_INT, -1}] = 0;
-            itervalToDdIndex[i][{coefficientSum, DUMMY_MAX_INT}] = 1;
+// sums out all ddVars in one weighted traversal of dd
+void Counter::abstractCube(Dd& dd, const Set<Int>& ddVars, const Map<Int, Number> &literalWeights) {
+    if (verbosityLevel >= 2) {
+        for (Int ddVar : ddVars) {
+            util::printComment("project " + to_string(ddVar));
         }
-        itervalToDdIndex[clauseVarSize][{DUMMY_MIN_INT, -1}] = 0;
-        itervalToDdIndex[clauseVarSize][{0, DUMMY_MAX_INT}] = 1;
-
-        Int lf, rt;
+    }
+    dd = dd.getAbstraction(ddVars, ddVarToCnfVarMap, literalWeights, mgr);
+    dd.recordCounts("abstraction");
+}
 
-        return constructDd(clausePbfVarOrder, itervalToDdIndex, structedDd, 0, lf, rt, limit);
-    } else if (option == EQUAL_WORD) {
-        vector<Map<Int, Int> > valueToDdIndex(clauseVarSize + 1);
-        vector<Dd> structedDd;
-        structedDd.push_back(Dd::getZeroDd(mgr));  // false
-        structedDd.push_back(Dd::getOneDd(mgr));   // true
-        Int coefficientSum = 0;
-        for (int i = clauseVarSize - 1; i >= 0; i--) {
-            // coefficientSum += clausePbfVarOrder[i].second.second;
-            coefficientSum += clausePbfVarOrder[i].second.second;
+// dd = abstraction of dd * factor, fused so the product is never built in full
+void Counter::abstractProduct(Dd& dd, const Dd& factor, const Set<Int>& ddVars, const Map<Int, Number> &literalWeights) {
+    if (verbosityLevel >= 2) {
+        for (Int ddVar : ddVars) {
+            util::printComment("project " + to_string(ddVar));
         }
-        valueToDdIndex[clauseVarSize][0] = 1; // present 0 = 0 is always true.
-        return constructDdEq(clausePbfVarOrder, valueToDdIndex, structedDd, coefficientSum, 0, limit); 
-    } else {
-        showError("Undefined option when getConstraintDd");
-        return Dd::getOneDd(mgr);
     }
+    dd = dd.getProductAbstraction(factor, ddVars, ddVarToCnfVarMap, literalWeights, mgr);
+    dd.recordCounts("abstraction");
 }
 
-// Compose 其实就是一个 project 变量, 通过赋值 Dd 的时候计算的过程
-// 这里改了加权版本的
-void Counter::abstract(Dd& dd, Int ddVar, const Map<Int, Number> &literalWeights) {
-    if (verbosityLevel >= 2) util::printComment("project " + to_string(ddVar));
+// abstraction of the product of all factors, in the order given by productScheduling
+Dd Counter::multiplyAndAbstract(const vector<Dd>& factors, const Set<Int>& ddVars, const Map<Int, Number> &literalWeights) {
+    if (factors.empty()) {
+        Dd dd = Dd::getOneDd(mgr);
+        abstractCube(dd, ddVars, literalWeights);
+        return dd;
+    }
 
-    Int pbfVar = ddVarToCnfVarMap[ddVar];
+    if (productScheduling == ProductScheduling::CONSTRAINT_ORDER) {
+        Dd dd = Dd::getOneDd(mgr);
+        for (Int i = 0; i + 1 < factors.size(); i++) {
+            dd = dd.getProduct(factors[i]);
+        }
+        dd.recordCounts("product");
+        abstractProduct(dd, factors.back(), ddVars, literalWeights);  // last product fused with the abstraction
+        return dd;
+    }
 
-    Dd positiveWeight = Dd::getConstDd(literalWeights.at(pbfVar), mgr);
-    Dd negativeWeight = Dd::getConstDd(literalWeights.at(-pbfVar), mgr);
+    struct QueuedFactor {
+        Dd dd;
+        Set<Int> support;
+        size_t size;  // node count, or support size while counting in parallel
+        Int abstractableVarCount;  // members of ddVars in support
+    };
+    auto isCostlier = [](const QueuedFactor& factor1, const QueuedFactor& factor2) {  // top of the queue is the cheapest factor
+        if (factor1.size != factor2.size) return factor1.size > factor2.size;
+        return factor1.abstractableVarCount < factor2.abstractableVarCount;  // ties go to the factor sharing more vars with the cube
+    };
+    std::priority_queue<QueuedFactor, vector<QueuedFactor>, decltype(isCostlier)> queue(isCostlier);
+
+    Map<Int, Int> occurrenceCounts;  // ddVar in ddVars |-> number of queued factors depending on it
+    auto enqueue = [&](const Dd& dd) {
+        QueuedFactor factor{dd, dd.getSupport(), 0, 0};
+        // Sylvan counts nodes by marking them, which races with the Lace tasks of sibling subtrees building nodes
+        factor.size = countingInParallel() ? factor.support.size() : dd.getNodeCount();
+        for (Int ddVar : factor.support) {
+            if (util::isFound(ddVar, ddVars)) {
+                occurrenceCounts[ddVar]++;
+                factor.abstractableVarCount++;
+            }
+        }
+        queue.push(factor);
+    };
+    for (const Dd& factor : factors) {
+        enqueue(factor);
+    }
 
-    Dd highTerm = dd.getComposition(ddVar, true, mgr).getProduct(positiveWeight);
-    Dd lowTerm  = dd.getComposition(ddVar, false, mgr).getProduct(negativeWeight);
-    
-    // dd = positiveWeight * dd.Compose(mgr.addOne(), ddVar) + negativeWeight * dd.Compose(mgr.addZero(), ddVar);
-    dd = highTerm.getSum(lowTerm);
-}
+    Set<Int> remainingDdVars = ddVars;
+    while (queue.size() > 1) {
+        QueuedFactor factor1 = queue.top();
+        queue.pop();
+        QueuedFactor factor2 = queue.top();
+        queue.pop();
+
+        Set<Int> abstractingDdVars;  // vars whose last occurrences this product consumes
+        for (const QueuedFactor* factor : {&factor1, &factor2}) {
+            for (Int ddVar : factor->support) {
+                if (util::isFound(ddVar, remainingDdVars) && --occurrenceCounts[ddVar] == 0) {
+                    abstractingDdVars.insert(ddVar);
+                }
+            }
+        }
+        if (queue.empty()) {  // last product also takes the vars no factor depends on
+            util::unionize(abstractingDdVars, remainingDdVars);
+        }
+        for (Int ddVar : abstractingDdVars) {
+            remainingDdVars.erase(ddVar);
+        }
 
-// dd.Compose
-void Counter::abstractCube(Dd& dd, const Set<Int>& ddVars, const Map<Int, Number> &literalWeights) {
-    for (Int ddVar : ddVars) {
-        abstract(dd, ddVar, literalWeights);
+        Dd product = factor1.dd;
+        if (abstractingDdVars.empty()) {
+            product = product.getProduct(factor2.dd);
+            product.recordCounts("product");
+        } else {
+            abstractProduct(product, factor2.dd, abstractingDdVars, literalWeights);
+        }
+        enqueue(product);
     }
+
+    Dd dd = queue.top().dd;
+    abstractCube(dd, remainingDdVars, literalWeights);  // nonempty only for a single factor
+    return dd;
 }
 
 void Counter::printJoinTree(const Pbf& pbf) const {
@@ -234,7 +221,7 @@ void Counter::printJoinTree(const Pbf& pbf) const {
 }
 
 void Counter::setJoinTree(const Pbf& pbf) {
-    if (pbf.getClauses().empty()) {  // empty cnf
+    if (pbf.getConstraints().empty()) {  // empty cnf
         // showWarning("cnf is empty"); // different warning for empty clause
         joinRoot = new JoinNonterminal(vector<JoinNode*>());
         return;
@@ -252,39 +239,227 @@ void Counter::setJoinTree(const Pbf& pbf) {
 Dd Counter::countSubtree(JoinNode* joinNode, const Pbf& pbf, Set<Int>& projectedCnfVars) {
     if (joinNode->isTerminal()) {
         Int index = joinNode->getNodeIndex();
-        return getConstraintDd(pbf.getClauses()[index], pbf.getCoefficients()[index], pbf.getOptions()[index], pbf.getLimits()[index]);
+        return getConstraintDd(pbf.getConstraints(), index);
     } else {
-        // ADD dd = mgr.addOne();
-        Dd dd = Dd::getOneDd(mgr);
-        for (JoinNode* child : joinNode->getChildren()) {
-            dd = dd.getProduct(countSubtree(child, pbf, projectedCnfVars));
+        const vector<JoinNode*>& children = joinNode->getChildren();
+        vector<Dd> childDds(children.size(), Dd::getOneDd(mgr));
+        if (countingInParallel() && children.size() > 1) {
+            vector<Set<Int>> childProjectedCnfVarSets(children.size());  // one per task, merged after syncing
+            LACE_ME;
+            Dd::parallelRegionCount++;
+            for (Int i = 0; i < children.size(); i++) {
+                SPAWN(countSubtreeTask, this, children[i], &pbf, &childProjectedCnfVarSets[i], &childDds[i]);
+            }
+            for (Int i = children.size() - 1; i >= 0; i--) {
+                SYNC(countSubtreeTask);
+            }
+            Dd::parallelRegionCount--;
+            for (const Set<Int>& childProjectedCnfVars : childProjectedCnfVarSets) {
+                util::unionize(projectedCnfVars, childProjectedCnfVars);
+            }
+        } else {
+            for (Int i = 0; i < children.size(); i++) {
+                childDds[i] = countSubtree(children[i], pbf, projectedCnfVars);
+            }
         }
+
+        // ADD dd = mgr.addOne();
+        Set<Int> projectingDdVars;
         for (Int cnfVar : joinNode->getProjectableCnfVars()) {
             projectedCnfVars.insert(cnfVar);
-
-            Int ddVar = cnfVarToDdVarMap[cnfVar];
-            abstract(dd, ddVar, pbf.getLiteralWeights());
+            projectingDdVars.insert(cnfVarToDdVarMap.at(cnfVar));  // read-only: called from several workers
         }
-        return dd;
+        return multiplyAndAbstract(childDds, projectingDdVars, pbf.getLiteralWeights());
     }
 }
 
+Number Counter::countJoinTree(const Pbf& pbf) {
+    orderDdVars(pbf);
+
+    JoinNode::resetStaticFields();  // terminal indexes must be clause indexes
+    setJoinTree(pbf);
+    if (verbosityLevel >= 3) printJoinTree(pbf);
+
+    Set<Int> projectedCnfVars;
+    return extractModelCount(countSubtree(joinRoot, pbf, projectedCnfVars), projectedCnfVars, pbf);
+}
+
 Number Counter::getModelCount(const Pbf& pbf) {
     Int i = pbf.getEmptyClauseIndex();
     if (i != DUMMY_MIN_INT) {  // empty clause found
         showWarning("clause " + to_string(i + 1) + " of cnf is empty (1-indexing)");
-        return 0;
+        laneModelCounts.assign(pbf.getLaneCount(), logCounting ? Number(NEGATIVE_INFINITY) : Number());
+        return laneModelCounts.front();
+    } else if (pbf.getLaneCount() > 1 && !LaneLeaf::isAvailable()) {
+        return countLanesSeparately(pbf);
     } else {
+        if (modularCounting) ModularField::init(pbf.getLiteralWeights());  // enough primes for this formula's count
+        if (pbf.getLaneCount() > 1) LaneLeaf::init(pbf.getLaneWeights());
         return computeModelCount(pbf);
     }
 }
 
+// CUDD and exact leaves have one value per leaf, so each lane is counted on its own
+Number Counter::countLanesSeparately(const Pbf& pbf) {
+    vector<Number> counts;
+    for (Int lane = 0; lane < pbf.getLaneCount(); lane++) {
+        Counter* counter = newCounter();
+        counts.push_back(counter->getModelCount(pbf.getLane(lane)));
+        delete counter;
+    }
+    laneModelCounts = counts;
+    return laneModelCounts.front();
+}
+
+// children write "componentIndex count..." lines (one count per lane) to their own temporary files, read back once all have exited
+// a Number is passed as its exact quotient ("num/den", or "num" if integral), or as a hexadecimal float without multiplePrecision
+vector<vector<Number>> Counter::countComponentsInWorkers(const vector<Pbf>& components) const {
+    vector<Int> componentIndices(components.size());  // largest first, dealt round-robin to the workers
+    for (Int i = 0; i < components.size(); i++) componentIndices[i] = i;
+    std::stable_sort(componentIndices.begin(), componentIndices.end(), [&components](Int i, Int j) {
+        return components[i].getConstraints().size() > components[j].getConstraints().size();
+    });
+
+    Int workerCount = std::min(componentWorkerCount, Int(components.size()));
+    vector<FILE*> resultFiles;
+    vector<pid_t> workers;
+    cout << std::flush;  // children must not repeat buffered output
+    for (Int worker = 0; worker < workerCount; worker++) {
+        FILE* resultFile = std::tmpfile();
+        if (resultFile == nullptr) showError("unable to create result file for component worker");
+        pid_t pid = fork();
+        if (pid < 0) showError("unable to fork component worker " + to_string(worker));
+        if (pid == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGKILL);  // no orphan keeps counting after a timeout
+            signal(SIGINT, SIG_DFL);
+            signal(SIGTERM, SIG_DFL);
+            for (Int k = worker; k < componentIndices.size(); k += workerCount) {
+                Counter* counter = newCounter();
+                counter->getModelCount(components[componentIndices[k]]);
+                std::ostringstream repr;
+                for (const Number& count : counter->laneModelCounts) {
+                    if (multiplePrecision) repr << " " << count.quotient.get_str();
+                    else repr << " " << std::hexfloat << count.fraction;
+                }
+                delete counter;
+                fprintf(resultFile, "%ld%s\n", long(componentIndices[k]), repr.str().c_str());
+            }
+            fflush(resultFile);
+            cout << std::flush;
+            _exit(0);
+        }
+        resultFiles.push_back(resultFile);
+        workers.push_back(pid);
+    }
+
+    for (pid_t pid : workers) {
+        int status;
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            showError("component worker " + to_string(pid) + " failed");
+        }
+    }
+
+    vector<vector<Number>> counts(components.size());
+    vector<bool> counted(components.size(), false);
+    char* line = nullptr;  // exact counts may run to many digits
+    size_t lineCapacity = 0;
+    for (FILE* resultFile : resultFiles) {
+        rewind(resultFile);
+        ssize_t lineLength;
+        while ((lineLength = getline(&line, &lineCapacity, resultFile)) > 0) {
+            std::string_view words(line, lineLength);
+            while (!words.empty() && words.back() == '\n') words.remove_suffix(1);
+            size_t space = words.find(' ');
+            Int componentIndex = util::parseInt(words.substr(0, space), 0);
+            while (space != std::string_view::npos) {
+                size_t nextSpace = words.find(' ', space + 1);
+                string field(words.substr(space + 1, nextSpace - space - 1));
+                counts.at(componentIndex).push_back(multiplePrecision ? Number(mpq_class(field)) : Number(field));  // Number(string) reads an integral quotient through mpf_class
+                space = nextSpace;
+            }
+            counted.at(componentIndex) = true;
+        }
+        fclose(resultFile);
+    }
+    free(line);
+    for (Int i = 0; i < components.size(); i++) {
+        if (!counted[i]) showError("component " + to_string(i) + " was not counted");
+    }
+    return counts;
+}
+
+// components are counted by fresh counters, so each gets its own dd var order and (with CUDD) its own manager
+// with Sylvan they are counted one after another, each by all Lace workers: a forked child has only the forking thread,
+// so Sylvan's garbage collection would wait forever at its barrier for the other workers (forking is fine for the
+// backbone workers, which only run RoundingSat), and components cannot be Lace tasks of one process while
+// the join-tree indices and the ModularField and LaneLeaf weights are static
+Number Counter::countComponents(const Pbf& pbf) {
+    if (pbf.getEmptyClauseIndex() != DUMMY_MIN_INT) return getModelCount(pbf);
+
+    vector<Pbf> components = pbf.getComponents();
+    if (verbosityLevel >= 1) util::printRow("components", components.size());
+    if (components.size() <= 1) return getModelCount(pbf);
+
+    vector<vector<Number>> counts;  // component |-> lane |-> count
+    if (componentWorkerCount > 1 && ddPackage == CUDD_PACKAGE) {
+        counts = countComponentsInWorkers(components);
+    } else {
+        for (const Pbf& component : components) {
+            Counter* counter = newCounter();
+            counter->getModelCount(component);
+            counts.push_back(counter->laneModelCounts);
+            delete counter;
+        }
+    }
+
+    laneModelCounts.clear();
+    for (Int lane = 0; lane < pbf.getLaneCount(); lane++) {
+        Number modelCount = pbf.getUnconstrainedWeight(lane);
+        for (const vector<Number>& componentCounts : counts) {
+            const Number& count = componentCounts.at(lane);
+            modelCount = logCounting ? Number(modelCount.fraction + count.fraction) : modelCount * count;
+        }
+        laneModelCounts.push_back(modelCount);
+    }
+    return laneModelCounts.front();
+}
+
+// the diagram stays whole, unlike the counters' abstracted ones, so it may be far larger than any of theirs
+void Counter::compile(const Pbf& pbf, const string& filePath) {
+    printComment("Compiling diagram...", 1);
+    orderDdVars(pbf);
+    Dd cnfDd = Dd::getOneDd(mgr);
+    if (pbf.getEmptyClauseIndex() != DUMMY_MIN_INT) {
+        cnfDd = Dd::getZeroDd(mgr);
+    } else {
+        const PbConstraintStore& constraints = pbf.getConstraints();
+        for (Int i = 0; i < constraints.size(); i++) {
+            cnfDd = cnfDd.getProduct(getConstraintDd(constraints, i));
+        }
+    }
+    cnfDd.recordCounts("compilation");
+
+    CompiledDiagram diagram(cnfDd, ddVarToCnfVarMap, pbf.getSubstitutions(), mgr);
+    diagram.write(filePath);
+    if (verbosityLevel >= 1) util::printRow("compiledNodes", diagram.getNodeCount());
+
+    laneModelCounts.clear();  // the formula's weights have been substituted already
+    for (Int lane = 0; lane < pbf.getLaneCount(); lane++) laneModelCounts.push_back(diagram.evaluate(pbf.getLaneWeights(lane)));
+}
+
 void Counter::output(const string& filePath, WeightFormat weightFormat) {
-    Pbf pbf(filePath, weightFormat);
+    Pbf pbf;
+    PbfCacheKey cacheKey = Pbf::getCacheKey(filePath, weightFormat);
+    bool readingCache = !cacheFilePath.empty() && compileFilePath.empty();  // a cached formula has lost the preprocessor's substitutions
+    if (!readingCache || !pbf.readCache(cacheFilePath, cacheKey)) {  // a cache holds the preprocessed formula
+        pbf = Pbf(filePath, weightFormat);
+
+        if(preprocessorFlag) {
+            Preprocessor preprocessor(pbf);
+            preprocessor.getPreprocessedPbf(pbf);
+        }
 
-    if(preprocessorFlag) {
-        Preprocessor preprocessor(pbf);
-        preprocessor.getPreprocessedPbf(pbf);
+        if (!cacheFilePath.empty()) pbf.writeCache(cacheFilePath, cacheKey);
     }
 
     // printComment("After preprocess...");
@@ -296,11 +471,17 @@ void Counter::output(const string& filePath, WeightFormat weightFormat) {
     signal(SIGINT, handleSignals);   // Ctrl c
     signal(SIGTERM, handleSignals);  // timeout
 
-    util::printSolutionLine(getModelCount(pbf), weightFormat);
+    if (compileFilePath.empty()) {
+        countComponents(pbf);
+    } else {
+        compile(pbf, compileFilePath);
+    }
+    for (Int lane = 0; lane < laneModelCounts.size(); lane++) {  // one solution line per weight vector, in input order
+        util::printSolutionLine(laneModelCounts[lane], weightFormat, lane == 0, lane + 1 == laneModelCounts.size());
+    }
 
     if(verbosityLevel >= 2) {
-        util::printRow("maxDiagramLeaves", Dd::maxDdLeafCount);
-        util::printRow("maxDiagramNodes", Dd::maxDdNodeCount);
+        Dd::printMaxCounts();
     } 
 }
 
@@ -308,12 +489,9 @@ void Counter::output(const string& filePath, WeightFormat weightFormat) {
 
 void MonolithicCounter::setMonolithicClauseDds(vector<Dd>& clauseDds, const Pbf& pbf) {
     clauseDds.clear();
-    const vector<vector<Int>>& clauses = pbf.getClauses();
-    const vector<vector<Int>>& coefficients = pbf.getCoefficients();
-    const vector<string>& options = pbf.getOptions();
-    const vector<Int>& limits = pbf.getLimits();
-    for (int i = 0; i < clauses.size(); i++) {
-        Dd clauseDd = getConstraintDd(clauses[i], coefficients[i], options[i], limits[i]);
+    const PbConstraintStore& constraints = pbf.getConstraints();
+    for (Int i = 0; i < constraints.size(); i++) {
+        Dd clauseDd = getConstraintDd(constraints, i);
         clauseDds.push_back(clauseDd);
     }
 }
@@ -321,16 +499,17 @@ void MonolithicCounter::setMonolithicClauseDds(vector<Dd>& clauseDds, const Pbf&
 void MonolithicCounter::setCnfDd(Dd& pbfDd, const Pbf& pbf) {
     vector<Dd> clauseDds;
     setMonolithicClauseDds(clauseDds, pbf);
-    pbfDd = mgr.addOne();
+    pbfDd = Dd::getOneDd(mgr);  // log10(1) if logCounting
     for (const Dd& clauseDd : clauseDds) {
         // pbfDd &= clauseDd;  // operator& is operator* in class ADD
         pbfDd = pbfDd.getProduct(clauseDd);
     }
+    pbfDd.recordCounts("product");
 }
 
 void MonolithicCounter::constructJoinTree(const Pbf& pbf) {
     vector<JoinNode*> terminals;
-    for (Int clauseIndex = 0; clauseIndex < pbf.getClauses().size(); clauseIndex++) {
+    for (Int clauseIndex = 0; clauseIndex < pbf.getConstraints().size(); clauseIndex++) {
         terminals.push_back(new JoinTerminal());
     }
 
@@ -347,14 +526,14 @@ Number MonolithicCounter::computeModelCount(const Pbf& pbf) {
 
     // Set<Int> support = util::getSupport(cnfDd);
     Set<Int> support = cnfDd.getSupport();
-    for (Int ddVar : support) {
-        abstract(cnfDd, ddVar, pbf.getLiteralWeights());
-    }
+    abstractCube(cnfDd, support, pbf.getLiteralWeights());
 
     // Float modelCount = diagram::countConstDdFloat(cnfDd);
-    Number modelCount = cnfDd.extractConst();
-    modelCount = util::adjustModelCount(modelCount, getCnfVars(support), pbf.getLiteralWeights());
-    return modelCount;
+    return extractModelCount(cnfDd, getCnfVars(support), pbf);
+}
+
+Counter* MonolithicCounter::newCounter() const {
+    return new MonolithicCounter(ddVarOrderingHeuristic, inverseDdVarOrdering);
 }
 
 MonolithicCounter::MonolithicCounter(VarOrderingHeuristic ddVarOrderingHeuristic, bool inverseDdVarOrdering) {
@@ -366,12 +545,12 @@ MonolithicCounter::MonolithicCounter(VarOrderingHeuristic ddVarOrderingHeuristic
 
 /* class LinearCounter ******************************************************/
 
-void LinearCounter::fillProjectableCnfVarSets(const vector<vector<Int>>& clauses) {
-    projectableCnfVarSets = vector<Set<Int>>(clauses.size(), Set<Int>());
+void LinearCounter::fillProjectableCnfVarSets(const PbConstraintStore& constraints) {
+    projectableCnfVarSets = vector<Set<Int>>(constraints.size(), Set<Int>());
 
     Set<Int> placedCnfVars;  // cumulates vars placed in projectableCnfVarSets so far
-    for (Int clauseIndex = clauses.size() - 1; clauseIndex >= 0; clauseIndex--) {
-        Set<Int> clauseCnfVars = util::getClauseCnfVars(clauses[clauseIndex]);
+    for (Int clauseIndex = constraints.size() - 1; clauseIndex >= 0; clauseIndex--) {
+        Set<Int> clauseCnfVars = util::getClauseCnfVars(constraints.getLiterals(clauseIndex));
 
         Set<Int> placingCnfVars;
         util::differ(placingCnfVars, clauseCnfVars, placedCnfVars);
@@ -382,31 +561,28 @@ void LinearCounter::fillProjectableCnfVarSets(const vector<vector<Int>>& clauses
 
 void LinearCounter::setLinearClauseDds(vector<Dd>& clauseDds, const Pbf& pbf) {
     clauseDds.clear();
-    clauseDds.push_back(mgr.addOne());
+    clauseDds.push_back(Dd::getOneDd(mgr));  // log10(1) if logCounting
     // for (const vector<Int> &clause : cnf.getClauses()) {
     // ADD clauseDd = getClauseDd(clause);
-    const vector<vector<Int>>& clauses = pbf.getClauses();
-    const vector<vector<Int>>& coefficients = pbf.getCoefficients();
-    const vector<string> options = pbf.getOptions();
-    const vector<Int>& limits = pbf.getLimits();
-    for (int i = 0; i < clauses.size(); i++) {
-        Dd clauseDd = getConstraintDd(clauses[i], coefficients[i], options[i], limits[i]);
+    const PbConstraintStore& constraints = pbf.getConstraints();
+    for (Int i = 0; i < constraints.size(); i++) {
+        Dd clauseDd = getConstraintDd(constraints, i);
         clauseDds.push_back(clauseDd);
     }
 }
 
 void LinearCounter::constructJoinTree(const Pbf& pbf) {
-    const vector<vector<Int>>& clauses = pbf.getClauses();
-    fillProjectableCnfVarSets(clauses);
+    const PbConstraintStore& constraints = pbf.getConstraints();
+    fillProjectableCnfVarSets(constraints);
 
     vector<JoinNode*> clauseNodes;
-    for (Int clauseIndex = 0; clauseIndex < clauses.size(); clauseIndex++) {
+    for (Int clauseIndex = 0; clauseIndex < constraints.size(); clauseIndex++) {
         clauseNodes.push_back(new JoinTerminal());
     }
 
     joinRoot = new JoinNonterminal({clauseNodes[0]}, projectableCnfVarSets[0]);
 
-    for (Int clauseIndex = 1; clauseIndex < clauses.size(); clauseIndex++) {
+    for (Int clauseIndex = 1; clauseIndex < constraints.size(); clauseIndex++) {
         joinRoot = new JoinNonterminal({joinRoot, clauseNodes[clauseIndex]}, projectableCnfVarSets[clauseIndex]);
     }
 }
@@ -417,29 +593,34 @@ Number LinearCounter::computeModelCount(const Pbf& pbf) {
     vector<Dd> factorDds;
     setLinearClauseDds(factorDds, pbf);
     Set<Int> projectedCnfVars;
+    if (productScheduling == ProductScheduling::SMALLEST_FIRST) {  // the scheduler abstracts each var after its last factor
+        Set<Int> ddVars = util::getSupportSuperset(factorDds);
+        return extractModelCount(multiplyAndAbstract(factorDds, ddVars, pbf.getLiteralWeights()), getCnfVars(ddVars), pbf);
+    }
     while (factorDds.size() > 1) {
         Dd factor1 = Dd::getOneDd(mgr), factor2 = Dd::getOneDd(mgr);
         util::popBack(factor1, factorDds);
         util::popBack(factor2, factorDds);
 
-        // ADD product = factor1 * factor2;
-        Dd product = factor1.getProduct(factor2);
-        Set<Int> productDdVars = product.getSupport();
+        Set<Int> productDdVars = factor1.getSupport();
+        util::unionize(productDdVars, factor2.getSupport());
 
         Set<Int> otherDdVars = util::getSupportSuperset(factorDds);
 
         Set<Int> projectingDdVars;
         util::differ(projectingDdVars, productDdVars, otherDdVars);
-        abstractCube(product, projectingDdVars, pbf.getLiteralWeights());
+        abstractProduct(factor1, factor2, projectingDdVars, pbf.getLiteralWeights());
         util::unionize(projectedCnfVars, getCnfVars(projectingDdVars));
 
-        factorDds.push_back(product);
+        factorDds.push_back(factor1);
     }
 
     // Number modelCount = diagram::countConstDdFloat(util::getSoleMember(factorDds));
-    Number modelCount = util::getSoleMember(factorDds).extractConst();
-    modelCount = util::adjustModelCount(modelCount, projectedCnfVars, pbf.getLiteralWeights());
-    return modelCount;
+    return extractModelCount(util::getSoleMember(factorDds), projectedCnfVars, pbf);
+}
+
+Counter* LinearCounter::newCounter() const {
+    return new LinearCounter(ddVarOrderingHeuristic, inverseDdVarOrdering);
 }
 
 LinearCounter::LinearCounter(VarOrderingHeuristic ddVarOrderingHeuristic, bool inverseDdVarOrdering) {
@@ -449,7 +630,7 @@ LinearCounter::LinearCounter(VarOrderingHeuristic ddVarOrderingHeuristic, bool i
 
 /* class NonlinearCounter ********************************************************/
 
-void NonlinearCounter::printClusters(const vector<vector<Int>>& clauses, const vector<vector<Int>>& coefficients, const vector<string> &options, const vector<Int>& limits) const {
+void NonlinearCounter::printClusters(const PbConstraintStore& constraints) const {
     printThinLine();
     printComment("clusters {");
     for (Int clusterIndex = 0; clusterIndex < clusters.size(); clusterIndex++) {
@@ -461,17 +642,28 @@ void NonlinearCounter::printClusters(const vector<vector<Int>>& clauses, const v
             cout << COMMENT_WORD << "\t\t"
                                     "constraint "
                  << clauseIndex + 1 << +":\t";
-            util::printConstraint(clauses[clauseIndex], coefficients[clauseIndex], options[clauseIndex], limits[clauseIndex]);
+            util::printConstraint(constraints.getLiterals(clauseIndex), constraints.getCoefficients(clauseIndex), constraints.getRelation(clauseIndex), constraints.getLimit(clauseIndex));
         }
     }
     printComment("}");
     printThinLine();
 }
 
-void NonlinearCounter::fillClusters(const vector<vector<Int>>& clauses, const vector<Int>& cnfVarOrdering, bool usingMinVar) {
+vector<Int> NonlinearCounter::getCnfVarOrdering(const Pbf& pbf) const {
+    Int inducedWidth;
+    vector<Int> cnfVarOrdering = pbf.getVarOrdering(cnfVarOrderingHeuristic, inverseCnfVarOrdering, inducedWidth);
+    if (inducedWidth == DUMMY_MIN_INT && verbosityLevel >= 2) {  // a separate fill-in simulation, as costly as minfill itself
+        inducedWidth = pbf.getInducedWidth(cnfVarOrdering);
+    }
+    if (inducedWidth != DUMMY_MIN_INT && verbosityLevel >= 1) util::printRow("inducedWidth", inducedWidth);  // predicts the size of the largest cluster
+    return cnfVarOrdering;
+}
+
+void NonlinearCounter::fillClusters(const PbConstraintStore& constraints, const vector<Int>& cnfVarOrdering, bool usingMinVar) {
     clusters = vector<vector<Int>>(cnfVarOrdering.size(), vector<Int>());
-    for (Int clauseIndex = 0; clauseIndex < clauses.size(); clauseIndex++) {
-        Int clusterIndex = usingMinVar ? util::getMinClauseRank(clauses[clauseIndex], cnfVarOrdering) : util::getMaxClauseRank(clauses[clauseIndex], cnfVarOrdering);
+    for (Int clauseIndex = 0; clauseIndex < constraints.size(); clauseIndex++) {
+        Span<Int> clause = constraints.getLiterals(clauseIndex);
+        Int clusterIndex = usingMinVar ? util::getMinClauseRank(clause, cnfVarOrdering) : util::getMaxClauseRank(clause, cnfVarOrdering);
         clusters[clusterIndex].push_back(clauseIndex);
     }
 }
@@ -509,13 +701,13 @@ void NonlinearCounter::printProjectableCnfVarSets() const {
     printThinLine();
 }
 
-void NonlinearCounter::fillCnfVarSets(const vector<vector<Int>>& clauses, bool usingMinVar) {
+void NonlinearCounter::fillCnfVarSets(const PbConstraintStore& constraints, bool usingMinVar) {
     occurrentCnfVarSets = vector<Set<Int>>(clusters.size(), Set<Int>());
     projectableCnfVarSets = vector<Set<Int>>(clusters.size(), Set<Int>());
 
     Set<Int> placedCnfVars;  // cumulates vars placed in projectableCnfVarSets so far
     for (Int clusterIndex = clusters.size() - 1; clusterIndex >= 0; clusterIndex--) {
-        Set<Int> clusterCnfVars = util::getClusterCnfVars(clusters[clusterIndex], clauses);
+        Set<Int> clusterCnfVars = constraints.getVars(clusters[clusterIndex]);
 
         occurrentCnfVarSets[clusterIndex] = clusterCnfVars;
 
@@ -526,18 +718,18 @@ void NonlinearCounter::fillCnfVarSets(const vector<vector<Int>>& clauses, bool u
     }
 }
 
-Set<Int> NonlinearCounter::getProjectingDdVars(Int clusterIndex, bool usingMinVar, const vector<Int>& cnfVarOrdering, const vector<vector<Int>>& clauses) {
+Set<Int> NonlinearCounter::getProjectingDdVars(Int clusterIndex, bool usingMinVar, const vector<Int>& cnfVarOrdering, const PbConstraintStore& constraints) {
     Set<Int> projectableCnfVars;
 
     if (usingMinVar) {  // bucket elimination
         projectableCnfVars.insert(cnfVarOrdering[clusterIndex]);
     } else {  // Bouquet's Method
-        Set<Int> activeCnfVars = util::getClusterCnfVars(clusters[clusterIndex], clauses);
+        Set<Int> activeCnfVars = constraints.getVars(clusters[clusterIndex]);
 
         Set<Int> otherCnfVars;
         // 后续的 cluster 还没访问，将后续没有了的 Var 进行 project
         for (Int i = clusterIndex + 1; i < clusters.size(); i++) {
-            util::unionize(otherCnfVars, util::getClusterCnfVars(clusters[i], clauses));
+            util::unionize(otherCnfVars, constraints.getVars(clusters[i]));
         }
 
         // projectableCnfVars = activeCnfVars \ otherCnfVars
@@ -552,28 +744,28 @@ Set<Int> NonlinearCounter::getProjectingDdVars(Int clusterIndex, bool usingMinVa
     return projectingDdVars;
 }
 
-void NonlinearCounter::fillDdClusters(const vector<vector<Int>>& clauses, const vector<vector<Int>>& coefficients, const vector<string>& options, const vector<Int>& limits, const vector<Int>& cnfVarOrdering, bool usingMinVar) {
-    fillClusters(clauses, cnfVarOrdering, usingMinVar);
+void NonlinearCounter::fillDdClusters(const PbConstraintStore& constraints, const vector<Int>& cnfVarOrdering, bool usingMinVar) {
+    fillClusters(constraints, cnfVarOrdering, usingMinVar);
     if (verbosityLevel >= 2)
-        printClusters(clauses, coefficients, options, limits);
+        printClusters(constraints);
 
     ddClusters = vector<vector<Dd> >(clusters.size(), vector<Dd>());
     for (Int clusterIndex = 0; clusterIndex < clusters.size(); clusterIndex++) {
         for (Int clauseIndex : clusters[clusterIndex]) {
             // ADD clauseDd = getClauseDd(clauses[clauseIndex]);
-            Dd clauseDd = getConstraintDd(clauses[clauseIndex], coefficients[clauseIndex], options[clauseIndex], limits[clauseIndex]);
+            Dd clauseDd = getConstraintDd(constraints, clauseIndex);
 
             ddClusters[clusterIndex].push_back(clauseDd);
         }
     }
 }
 
-void NonlinearCounter::fillProjectingDdVarSets(const vector<vector<Int>>& clauses, const vector<vector<Int>>& coefficients, const vector<string>& options, const vector<Int>& limits, const vector<Int>& cnfVarOrdering, bool usingMinVar) {
-    fillDdClusters(clauses, coefficients, options, limits, cnfVarOrdering, usingMinVar);
+void NonlinearCounter::fillProjectingDdVarSets(const PbConstraintStore& constraints, const vector<Int>& cnfVarOrdering, bool usingMinVar) {
+    fillDdClusters(constraints, cnfVarOrdering, usingMinVar);
 
     projectingDdVarSets = vector<Set<Int>>(clusters.size(), Set<Int>());
     for (Int clusterIndex = 0; clusterIndex < ddClusters.size(); clusterIndex++) {
-        projectingDdVarSets[clusterIndex] = getProjectingDdVars(clusterIndex, usingMinVar, cnfVarOrdering, clauses);
+        projectingDdVarSets[clusterIndex] = getProjectingDdVars(clusterIndex, usingMinVar, cnfVarOrdering, constraints);
     }
 }
 
@@ -612,24 +804,21 @@ Int NonlinearCounter::getNewClusterIndex(const Set<Int>& remainingDdVars) const
 }
 
 void NonlinearCounter::constructJoinTreeUsingListClustering(const Pbf& pbf, bool usingMinVar) {
-    vector<Int> cnfVarOrdering = pbf.getVarOrdering(cnfVarOrderingHeuristic, inverseCnfVarOrdering);
-    const vector<vector<Int>>& clauses = pbf.getClauses();
-    const vector<vector<Int>>& coefficients = pbf.getCoefficients();
-    const vector<string>& options = pbf.getOptions();
-    const vector<Int>& limits = pbf.getLimits();
+    vector<Int> cnfVarOrdering = getCnfVarOrdering(pbf);
+    const PbConstraintStore& constraints = pbf.getConstraints();
 
-    fillClusters(clauses, cnfVarOrdering, usingMinVar);
+    fillClusters(constraints, cnfVarOrdering, usingMinVar);
     if (verbosityLevel >= 2)
-        printClusters(clauses, coefficients, options, limits);
+        printClusters(constraints);
 
-    fillCnfVarSets(clauses, usingMinVar);
+    fillCnfVarSets(constraints, usingMinVar);
     if (verbosityLevel >= 2) {
         printOccurrentCnfVarSets();
         printProjectableCnfVarSets();
     }
 
     vector<JoinNode*> terminals;
-    for (Int clauseIndex = 0; clauseIndex < clauses.size(); clauseIndex++) {
+    for (Int clauseIndex = 0; clauseIndex < constraints.size(); clauseIndex++) {
         terminals.push_back(new JoinTerminal());
     }
 
@@ -663,24 +852,21 @@ void NonlinearCounter::constructJoinTreeUsingListClustering(const Pbf& pbf, bool
 }
 
 void NonlinearCounter::constructJoinTreeUsingTreeClustering(const Pbf& pbf, bool usingMinVar) {
-    vector<Int> cnfVarOrdering = pbf.getVarOrdering(cnfVarOrderingHeuristic, inverseCnfVarOrdering);
-    const vector<vector<Int>>& clauses = pbf.getClauses();
-    const vector<vector<Int>>& coefficients = pbf.getCoefficients();
-    const vector<string>& options = pbf.getOptions();
-    const vector<Int>& limits = pbf.getLimits();
+    vector<Int> cnfVarOrdering = getCnfVarOrdering(pbf);
+    const PbConstraintStore& constraints = pbf.getConstraints();
 
-    fillClusters(clauses, cnfVarOrdering, usingMinVar);
+    fillClusters(constraints, cnfVarOrdering, usingMinVar);
     if (verbosityLevel >= 2)
-        printClusters(clauses, coefficients, options, limits);
+        printClusters(constraints);
 
-    fillCnfVarSets(clauses, usingMinVar);
+    fillCnfVarSets(constraints, usingMinVar);
     if (verbosityLevel >= 2) {
         printOccurrentCnfVarSets();
         printProjectableCnfVarSets();
     }
 
     vector<JoinNode*> terminals;
-    for (Int clauseIndex = 0; clauseIndex < clauses.size(); clauseIndex++) {
+    for (Int clauseIndex = 0; clauseIndex < constraints.size(); clauseIndex++) {
         terminals.push_back(new JoinTerminal());
     }
 
@@ -732,14 +918,11 @@ Number NonlinearCounter::countUsingListClustering(const Pbf& pbf, bool usingMinV
     if (verbosityLevel >= 2) util::printComment("Call counting using List Clustering");
     orderDdVars(pbf);
 
-    vector<Int> cnfVarOrdering = pbf.getVarOrdering(cnfVarOrderingHeuristic, inverseCnfVarOrdering);
-    const vector<vector<Int>>& clauses = pbf.getClauses();  // 这里是用 const 的引用 应用了 clauses
-    const vector<vector<Int>>& coefficents = pbf.getCoefficients();
-    const vector<string> options = pbf.getOptions();
-    const vector<Int> limits = pbf.getLimits();
+    vector<Int> cnfVarOrdering = getCnfVarOrdering(pbf);
+    const PbConstraintStore& constraints = pbf.getConstraints();  // 这里是用 const 的引用 应用了 constraints
 
-    fillClusters(clauses, cnfVarOrdering, usingMinVar);  // cluster - 满足某种条件的 clause 组成的集合
-    if (verbosityLevel >= 2) printClusters(clauses, coefficents, options, limits);
+    fillClusters(constraints, cnfVarOrdering, usingMinVar);  // cluster - 满足某种条件的 clause 组成的集合
+    if (verbosityLevel >= 2) printClusters(constraints);
 
     /* builds ADD for CNF: */
     // ADD cnfDd = mgr.addOne();
@@ -747,20 +930,18 @@ Number NonlinearCounter::countUsingListClustering(const Pbf& pbf, bool usingMinV
     Set<Int> projectedCnfVars;
     for (Int clusterIndex = 0; clusterIndex < clusters.size(); clusterIndex++) {
         /* builds ADD for cluster: */
-        // ADD clusterDd = mgr.addOne();
-        Dd clusterDd = Dd::getOneDd(mgr);
+        vector<Dd> clusterDds;
         const vector<Int>& clauseIndices = clusters[clusterIndex];
 
         if (verbosityLevel >= 2) util::printComment("Start to build cluster " + to_string(clusterIndex));
         for (Int clauseIndex : clauseIndices) {
             if (verbosityLevel >= 2) {
                 util::printComment("Start to build constraint");
-                util::printConstraint(clauses[clauseIndex], coefficents[clauseIndex], options[clauseIndex], limits[clauseIndex]);
-
-                vector<Int> clause = clauses[clauseIndex];
-                vector<Int> coefficent = coefficents[clauseIndex];
-                string option = options[clauseIndex];
-                Int limit = limits[clauseIndex];
+                Span<Int> clause = constraints.getLiterals(clauseIndex);
+                Span<Int> coefficent = constraints.getCoefficients(clauseIndex);
+                PbRelation relation = constraints.getRelation(clauseIndex);
+                Int limit = constraints.getLimit(clauseIndex);
+                util::printConstraint(clause, coefficent, relation, limit);
                 
                 for (int i = 0; i < clause.size(); i++) {
                     if(clause[i] > 0)
@@ -768,61 +949,43 @@ Number NonlinearCounter::countUsingListClustering(const Pbf& pbf, bool usingMinV
                     else 
                         cout << std::right << std::setw(5) << coefficent[i] << " x-" << cnfVarToDdVarMap[-clause[i]] << " ";
                 }
-                cout << std::right << std::setw(10) << option << " " << limit;
+                cout << std::right << std::setw(10) << util::getRelationWord(relation) << " " << limit;
                 cout << "\n";
             }
-            Dd clauseDd = getConstraintDd(clauses[clauseIndex], coefficents[clauseIndex], options[clauseIndex], limits[clauseIndex]);
+            Dd clauseDd = getConstraintDd(constraints, clauseIndex);
 
             if(verbosityLevel >= 4) {
                 std::cout << "construct clauseDd to => " + to_string(dotFileIndex) + ".dot" << std::endl;
                 writeDotFile(clauseDd, DOT_DIR);
             }
-            
-
-            // util::printComment("Call clusterDd *= clauseDd");
-            // clusterDd *= clauseDd;  // 乘操作得到了什么？
-
-            clusterDd = clusterDd.getProduct(clauseDd);
-
-            if(verbosityLevel >= 4) {
-                std::cout << "after *= clauseDd,  ouput clusterDd to => " + to_string(dotFileIndex) + ".dot" << std::endl;
-                writeDotFile(clusterDd);
-            }
-        }  // clusterDd 得到了每个 clause 的乘
 
-        if(verbosityLevel >= 4) {
-            std::cout << "after *= clauseDd loop,  ouput clusterDd to => " + to_string(dotFileIndex) + ".dot" << std::endl;
-            writeDotFile(clusterDd);
+            clusterDds.push_back(clauseDd);
         }
 
-        cnfDd = cnfDd.getProduct(clusterDd);
+        Set<Int> projectingDdVars = getProjectingDdVars(clusterIndex, usingMinVar, cnfVarOrdering, constraints);
+        clusterDds.push_back(cnfDd);  // last, so constraint order multiplies the cluster before cnfDd
+        cnfDd = multiplyAndAbstract(clusterDds, projectingDdVars, pbf.getLiteralWeights());
 
         if(verbosityLevel >= 4) {
-            std::cout << "after *= cluster ouput cnfDd to => " + to_string(dotFileIndex) + ".dot" << std::endl;
+            std::cout << "after *= cluster and abstraction ouput cnfDd to => " + to_string(dotFileIndex) + ".dot" << std::endl;
             writeDotFile(cnfDd, DOT_DIR);
         }
-
-        Set<Int> projectingDdVars = getProjectingDdVars(clusterIndex, usingMinVar, cnfVarOrdering, clauses);
-        abstractCube(cnfDd, projectingDdVars, pbf.getLiteralWeights());
         util::unionize(projectedCnfVars, getCnfVars(projectingDdVars));  // add projecting to projected
     }
 
     // Float modelCount = diagram::countConstDdFloat(cnfDd);
-    Number modelCount = cnfDd.extractConst();
-    modelCount = util::adjustModelCount(modelCount, cnfVarOrdering, pbf.getLiteralWeights());
-    return modelCount;
+    return extractModelCount(cnfDd, cnfVarOrdering, pbf);
 }
 
 Number NonlinearCounter::countUsingTreeClustering(const Pbf& pbf, bool usingMinVar) {
-    orderDdVars(pbf);
+    if (countingInParallel()) {  // clusters sharing no vars are sibling subtrees of the join tree, counted in parallel
+        return countJoinTree(pbf);
+    }
 
-    vector<Int> cnfVarOrdering = pbf.getVarOrdering(cnfVarOrderingHeuristic, inverseCnfVarOrdering);
-    const vector<vector<Int>>& clauses = pbf.getClauses();
-    const vector<vector<Int>>& coefficients = pbf.getCoefficients();
-    const vector<string>& options = pbf.getOptions();
-    const vector<Int>& limits = pbf.getLimits();
+    orderDdVars(pbf);
 
-    fillProjectingDdVarSets(clauses, coefficients, options, limits, cnfVarOrdering, usingMinVar);
+    vector<Int> cnfVarOrdering = getCnfVarOrdering(pbf);
+    fillProjectingDdVarSets(pbf.getConstraints(), cnfVarOrdering, usingMinVar);
 
     /* builds ADD for CNF: */
     // ADD cnfDd = mgr.addOne();
@@ -833,17 +996,11 @@ Number NonlinearCounter::countUsingTreeClustering(const Pbf& pbf, bool usingMinV
         const vector<Dd>& ddCluster = ddClusters[clusterIndex];
         if (!ddCluster.empty()) {
             /* builds ADD for cluster: */
-            // ADD clusterDd = mgr.addOne();
-            Dd clusterDd = Dd::getOneDd(mgr);
-            for (const Dd& dd : ddCluster)
-                // clusterDd *= dd;
-                clusterDd = clusterDd.getProduct(dd);
-
             Set<Int> projectingDdVars = projectingDdVarSets[clusterIndex];
             if (usingMinVar && projectingDdVars.size() != 1)
                 showError("wrong number of projecting vars (bucket elimination)");
 
-            abstractCube(clusterDd, projectingDdVars, pbf.getLiteralWeights());
+            Dd clusterDd = multiplyAndAbstract(ddCluster, projectingDdVars, pbf.getLiteralWeights());
             util::unionize(projectedCnfVars, getCnfVars(projectingDdVars));
 
             Int newClusterIndex = getNewClusterIndex(clusterDd, cnfVarOrdering, usingMinVar);
@@ -856,14 +1013,13 @@ Number NonlinearCounter::countUsingTreeClustering(const Pbf& pbf, bool usingMinV
             } else {  // no var remains
                 // cnfDd *= clusterDd;
                 cnfDd = cnfDd.getProduct(clusterDd);
+                cnfDd.recordCounts("product");
             }
         }
     }
 
     // Float modelCount = diagram::countConstDdFloat(cnfDd);
-    Number modelCount = cnfDd.extractConst();
-    modelCount = util::adjustModelCount(modelCount, projectedCnfVars, pbf.getLiteralWeights());
-    return modelCount;
+    return extractModelCount(cnfDd, projectedCnfVars, pbf);
 }
 
 /* class BucketCounter ********************************************************/
@@ -878,6 +1034,10 @@ Number BucketCounter::computeModelCount(const Pbf& pbf) {
     return usingTreeClustering ? NonlinearCounter::countUsingTreeClustering(pbf, usingMinVar) : NonlinearCounter::countUsingListClustering(pbf, usingMinVar);
 }
 
+Counter* BucketCounter::newCounter() const {
+    return new BucketCounter(usingTreeClustering, cnfVarOrderingHeuristic, inverseCnfVarOrdering, ddVarOrderingHeuristic, inverseDdVarOrdering);
+}
+
 BucketCounter::BucketCounter(bool usingTreeClustering, VarOrderingHeuristic cnfVarOrderingHeuristic, bool inverseCnfVarOrdering, VarOrderingHeuristic ddVarOrderingHeuristic, bool inverseDdVarOrdering) {
     this->usingTreeClustering = usingTreeClustering;
     this->cnfVarOrderingHeuristic = cnfVarOrderingHeuristic;
@@ -898,6 +1058,10 @@ Number BouquetCounter::computeModelCount(const Pbf& pbf) {
     return usingTreeClustering ? NonlinearCounter::countUsingTreeClustering(pbf, usingMinVar) : NonlinearCounter::countUsingListClustering(pbf, usingMinVar);
 }
 
+Counter* BouquetCounter::newCounter() const {
+    return new BouquetCounter(usingTreeClustering, cnfVarOrderingHeuristic, inverseCnfVarOrdering, ddVarOrderingHeuristic, inverseDdVarOrdering);
+}
+
 BouquetCounter::BouquetCounter(bool usingTreeClustering, VarOrderingHeuristic cnfVarOrderingHeuristic, bool inverseCnfVarOrdering, VarOrderingHeuristic ddVarOrderingHeuristic, bool inverseDdVarOrdering) {
     this->usingTreeClustering = usingTreeClustering;
     this->cnfVarOrderingHeuristic = cnfVarOrderingHeuristic;
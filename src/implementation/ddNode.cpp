@@ -1,9 +1,358 @@
 #include "../interface/ddNode.hpp"
 
+/* weighted abstraction ===================================================== */
+
+struct AbstractionWeights {  // constant Dds keep the weight leaves alive during an abstraction
+    Map<Int, Dd> negativeWeightDds;  // ddVar |-> weight of the negative literal
+    Map<Int, Dd> positiveWeightDds;  // ddVar |-> weight of the positive literal
+    Map<Int, Dd> sumWeightDds;       // ddVar |-> sum of both weights, for paths that skip ddVar
+    uint64_t opid;                   // Sylvan: fresh per abstraction, so cached results never mix weights
+    uint64_t productOpid;            // Sylvan: same, for the fused product
+};
+
+static AbstractionWeights getAbstractionWeights(
+    const Set<Int>& ddVars,
+    const vector<Int>& ddVarToCnfVarMap,
+    const Map<Int, Number>& literalWeights,
+    const Cudd& mgr
+) {
+    AbstractionWeights weights;
+    for (Int ddVar : ddVars) {
+        Int cnfVar = ddVarToCnfVarMap.at(ddVar);
+        if (LaneLeaf::isActive()) {  // literalWeights is lane 0 only
+            const vector<Float>& positiveLanes = LaneLeaf::getLiteralLanes(cnfVar);
+            const vector<Float>& negativeLanes = LaneLeaf::getLiteralLanes(-cnfVar);
+            vector<Float> sumLanes(LaneLeaf::laneCount);
+            for (Int lane = 0; lane < LaneLeaf::laneCount; lane++) sumLanes[lane] = positiveLanes[lane] + negativeLanes[lane];
+            weights.positiveWeightDds.emplace(ddVar, Dd(Mtbdd(LaneLeaf::getLeaf(positiveLanes))));
+            weights.negativeWeightDds.emplace(ddVar, Dd(Mtbdd(LaneLeaf::getLeaf(negativeLanes))));
+            weights.sumWeightDds.emplace(ddVar, Dd(Mtbdd(LaneLeaf::getLeaf(sumLanes))));
+            continue;
+        }
+        const Number& positiveWeight = literalWeights.at(cnfVar);
+        const Number& negativeWeight = literalWeights.at(-cnfVar);
+        weights.positiveWeightDds.emplace(ddVar, Dd::getConstDd(positiveWeight, mgr));
+        weights.negativeWeightDds.emplace(ddVar, Dd::getConstDd(negativeWeight, mgr));
+        weights.sumWeightDds.emplace(ddVar, Dd::getConstDd(positiveWeight + negativeWeight, mgr));
+    }
+    if (ddPackage == SYLVAN_PACKAGE) {
+        weights.opid = sylvan::cache_next_opid();
+        weights.productOpid = sylvan::cache_next_opid();
+    }
+    return weights;
+}
+
+TASK_2(MTBDD, weightedTimesTask, MTBDD, a, MTBDD, b) {
+    if (ModularField::isActive()) return modular_times(a, b);
+    if (LaneLeaf::isActive()) return lane_times(a, b);
+    if (logCounting) return log_times(a, b);
+    if (TieredLeaf::isActive()) return tiered_times(a, b);
+    return multiplePrecision ? gmp_times(a, b) : mtbdd_times(a, b);
+}
+
+TASK_2(MTBDD, weightedPlusTask, MTBDD, a, MTBDD, b) {
+    if (ModularField::isActive()) return modular_plus(a, b);
+    if (LaneLeaf::isActive()) return lane_plus(a, b);
+    if (logCounting) return log_plus(a, b);
+    if (TieredLeaf::isActive()) return tiered_plus(a, b);
+    return multiplePrecision ? gmp_plus(a, b) : mtbdd_plus(a, b);
+}
+
+// weight(-var) * low + weight(var) * high; low and high must be protected by the caller
+TASK_4(MTBDD, weightedSumTask, MTBDD, low, MTBDD, high, uint32_t, var, const AbstractionWeights*, weights) {
+    if (low == high) {
+        return CALL(weightedTimesTask, low, weights->sumWeightDds.at(var).mtbdd.GetMTBDD());
+    }
+    MTBDD weightedHigh = mtbdd_refs_push(CALL(weightedTimesTask, high, weights->positiveWeightDds.at(var).mtbdd.GetMTBDD()));
+    MTBDD weightedLow = mtbdd_refs_push(CALL(weightedTimesTask, low, weights->negativeWeightDds.at(var).mtbdd.GetMTBDD()));
+    MTBDD result = CALL(weightedPlusTask, weightedLow, weightedHigh);
+    mtbdd_refs_pop(2);
+    return result;
+}
+
+// cube is a Sylvan variable set; mtbdd_false is the zero background of every leaf type
+TASK_3(MTBDD, weightedAbstractTask, MTBDD, a, MTBDD, cube, const AbstractionWeights*, weights) {
+    if (a == sylvan::mtbdd_false || cube == sylvan::mtbdd_true) return a;
+
+    sylvan_gc_test();
+
+    MTBDD result;
+    if (sylvan::cache_get3(weights->opid, a, cube, 0, &result)) return result;
+
+    uint32_t cubeVar = mtbdd_getvar(cube);
+    MTBDD nextCube = mtbdd_gethigh(cube);
+    if (mtbdd_isleaf(a) || cubeVar < mtbdd_getvar(a)) {  // a does not depend on cubeVar
+        MTBDD rest = mtbdd_refs_push(CALL(weightedAbstractTask, a, nextCube, weights));
+        result = CALL(weightedTimesTask, rest, weights->sumWeightDds.at(cubeVar).mtbdd.GetMTBDD());
+        mtbdd_refs_pop(1);
+    } else {
+        bool abstracting = cubeVar == mtbdd_getvar(a);
+        MTBDD childCube = abstracting ? nextCube : cube;  // else the top var of a precedes every var still in the cube
+        mtbdd_refs_spawn(SPAWN(weightedAbstractTask, mtbdd_getlow(a), childCube, weights));
+        MTBDD high = mtbdd_refs_push(CALL(weightedAbstractTask, mtbdd_gethigh(a), childCube, weights));
+        MTBDD low = mtbdd_refs_push(mtbdd_refs_sync(SYNC(weightedAbstractTask)));
+        result = abstracting ? CALL(weightedSumTask, low, high, cubeVar, weights) : mtbdd_makenode(mtbdd_getvar(a), low, high);
+        mtbdd_refs_pop(2);
+    }
+
+    sylvan::cache_put3(weights->opid, a, cube, 0, result);
+    return result;
+}
+
+// abstraction of a * b; nodes of the product below an abstracted var are never built
+TASK_4(MTBDD, weightedProductAbstractTask, MTBDD, a, MTBDD, b, MTBDD, cube, const AbstractionWeights*, weights) {
+    if (a == sylvan::mtbdd_false || b == sylvan::mtbdd_false) return sylvan::mtbdd_false;
+    if (cube == sylvan::mtbdd_true) return CALL(weightedTimesTask, a, b);
+    if (mtbdd_isleaf(a) && mtbdd_isleaf(b)) {
+        MTBDD product = mtbdd_refs_push(CALL(weightedTimesTask, a, b));
+        MTBDD result = CALL(weightedAbstractTask, product, cube, weights);
+        mtbdd_refs_pop(1);
+        return result;
+    }
+    if (a > b) std::swap(a, b);  // the product commutes
+
+    sylvan_gc_test();
+
+    MTBDD result;
+    if (sylvan::cache_get3(weights->productOpid, a, b, cube, &result)) return result;
+
+    uint32_t var = mtbdd_isleaf(a) ? mtbdd_getvar(b) : mtbdd_isleaf(b) ? mtbdd_getvar(a) : std::min(mtbdd_getvar(a), mtbdd_getvar(b));
+    uint32_t cubeVar = mtbdd_getvar(cube);
+    MTBDD nextCube = mtbdd_gethigh(cube);
+    if (cubeVar < var) {  // neither factor depends on cubeVar
+        MTBDD rest = mtbdd_refs_push(CALL(weightedProductAbstractTask, a, b, nextCube, weights));
+        result = CALL(weightedTimesTask, rest, weights->sumWeightDds.at(cubeVar).mtbdd.GetMTBDD());
+        mtbdd_refs_pop(1);
+    } else {
+        MTBDD aLow = a, aHigh = a, bLow = b, bHigh = b;
+        if (!mtbdd_isleaf(a) && mtbdd_getvar(a) == var) {
+            aLow = mtbdd_getlow(a);
+            aHigh = mtbdd_gethigh(a);
+        }
+        if (!mtbdd_isleaf(b) && mtbdd_getvar(b) == var) {
+            bLow = mtbdd_getlow(b);
+            bHigh = mtbdd_gethigh(b);
+        }
+        bool abstracting = cubeVar == var;
+        MTBDD childCube = abstracting ? nextCube : cube;
+        mtbdd_refs_spawn(SPAWN(weightedProductAbstractTask, aLow, bLow, childCube, weights));
+        MTBDD high = mtbdd_refs_push(CALL(weightedProductAbstractTask, aHigh, bHigh, childCube, weights));
+        MTBDD low = mtbdd_refs_push(mtbdd_refs_sync(SYNC(weightedProductAbstractTask)));
+        result = abstracting ? CALL(weightedSumTask, low, high, cubeVar, weights) : mtbdd_makenode(var, low, high);
+        mtbdd_refs_pop(2);
+    }
+
+    sylvan::cache_put3(weights->productOpid, a, b, cube, result);
+    return result;
+}
+
+// CUDD computed tables of one abstraction; entries hold a reference, which the caller releases once the whole result is referenced
+using AbstractionCache = Mymap<Pair<DdNode*, Int>, DdNode*, HashFunc, EqualKey>;  // (f, cubeIndex) |-> result
+using ProductAbstractionCache = Mymap<Pair<DdNode*, DdNode*>, DdNode*, HashFunc, EqualKey>;  // (f, g) |-> result, one per cubeIndex
+
+static Int cuddLevel(DdManager* manager, DdNode* f) {
+    return cuddIsConstant(f) ? DUMMY_MAX_INT : cuddI(manager, f->index);
+}
+
+// apply operator for log10 leaves: log10(10^f + 10^g)
+static DdNode* cuddAddLogSumExp(DdManager* manager, DdNode** f, DdNode** g) {
+    DdNode* F = *f;
+    DdNode* G = *g;
+    if (cuddIsConstant(F) && cuddIsConstant(G)) {
+        return cuddUniqueConst(manager, Number(cuddV(F)).getLogSumExp(Number(cuddV(G))));
+    }
+    if (cuddIsConstant(F) && cuddV(F) == NEGATIVE_INFINITY) return G;
+    if (cuddIsConstant(G) && cuddV(G) == NEGATIVE_INFINITY) return F;
+    if (F > G) {  // the sum commutes, so one order suffices for the computed table
+        *f = G;
+        *g = F;
+    }
+    return NULL;
+}
+
+// log10 leaves multiply by adding and add by log-sum-exp
+static DD_AOP cuddTimes() {
+    return logCounting ? Cudd_addPlus : Cudd_addTimes;
+}
+
+static DD_AOP cuddPlus() {
+    return logCounting ? cuddAddLogSumExp : Cudd_addPlus;
+}
+
+static bool cuddIsZero(DdManager* manager, DdNode* f) {  // the constant of a zero count
+    return logCounting ? cuddIsConstant(f) && cuddV(f) == NEGATIVE_INFINITY : f == DD_ZERO(manager);
+}
+
+// weight(-cubeVar) * low + weight(cubeVar) * high; returns a referenced node or NULL, leaving low and high to the caller
+static DdNode* cuddWeightedSum(DdManager* manager, DdNode* low, DdNode* high, Int cubeVar, const AbstractionWeights& weights) {
+    DdNode* result;
+    if (low == high) {
+        result = cuddAddApplyRecur(manager, cuddTimes(), low, weights.sumWeightDds.at(cubeVar).cuadd.getNode());
+        if (result != NULL) cuddRef(result);
+        return result;
+    }
+    DdNode* weightedHigh = cuddAddApplyRecur(manager, cuddTimes(), high, weights.positiveWeightDds.at(cubeVar).cuadd.getNode());
+    if (weightedHigh == NULL) return NULL;
+    cuddRef(weightedHigh);
+    DdNode* weightedLow = cuddAddApplyRecur(manager, cuddTimes(), low, weights.negativeWeightDds.at(cubeVar).cuadd.getNode());
+    if (weightedLow == NULL) {
+        Cudd_RecursiveDeref(manager, weightedHigh);
+        return NULL;
+    }
+    cuddRef(weightedLow);
+    result = cuddAddApplyRecur(manager, cuddPlus(), weightedLow, weightedHigh);
+    if (result != NULL) cuddRef(result);
+    Cudd_RecursiveDeref(manager, weightedHigh);
+    Cudd_RecursiveDeref(manager, weightedLow);
+    return result;
+}
+
+// sums out cubeVars[cubeIndex..] (sorted by level) from f; returns NULL if CUDD runs out of memory
+static DdNode* cuddWeightedAbstractRecur(
+    DdManager* manager,
+    DdNode* f,
+    const vector<Int>& cubeVars,
+    Int cubeIndex,
+    const AbstractionWeights& weights,
+    AbstractionCache& cache
+) {
+    if (cubeIndex == cubeVars.size()) return f;
+
+    auto it = cache.find({f, cubeIndex});
+    if (it != cache.end()) return it->second;
+
+    Int cubeVar = cubeVars[cubeIndex];
+    DdNode* result;
+    if (cuddI(manager, cubeVar) < cuddLevel(manager, f)) {  // f does not depend on cubeVar
+        DdNode* rest = cuddWeightedAbstractRecur(manager, f, cubeVars, cubeIndex + 1, weights, cache);
+        if (rest == NULL) return NULL;
+        cuddRef(rest);
+        result = cuddAddApplyRecur(manager, cuddTimes(), rest, weights.sumWeightDds.at(cubeVar).cuadd.getNode());
+        if (result != NULL) cuddRef(result);
+        Cudd_RecursiveDeref(manager, rest);
+    } else {
+        bool abstracting = f->index == cubeVar;
+        Int childCubeIndex = abstracting ? cubeIndex + 1 : cubeIndex;  // else the top var of f precedes every var still in the cube
+        DdNode* high = cuddWeightedAbstractRecur(manager, cuddT(f), cubeVars, childCubeIndex, weights, cache);
+        if (high == NULL) return NULL;
+        cuddRef(high);
+        DdNode* low = cuddWeightedAbstractRecur(manager, cuddE(f), cubeVars, childCubeIndex, weights, cache);
+        if (low == NULL) {
+            Cudd_RecursiveDeref(manager, high);
+            return NULL;
+        }
+        cuddRef(low);
+        if (abstracting) {
+            result = cuddWeightedSum(manager, low, high, cubeVar, weights);
+        } else {
+            result = (high == low) ? high : cuddUniqueInter(manager, f->index, high, low);
+            if (result != NULL) cuddRef(result);
+        }
+        Cudd_RecursiveDeref(manager, high);
+        Cudd_RecursiveDeref(manager, low);
+    }
+    if (result == NULL) return NULL;
+
+    cache.emplace(Pair<DdNode*, Int>(f, cubeIndex), result);  // keeps the reference taken above
+    return result;
+}
+
+// sums out cubeVars[cubeIndex..] from f * g without building the product above them; returns NULL if CUDD runs out of memory
+static DdNode* cuddWeightedProductAbstractRecur(
+    DdManager* manager,
+    DdNode* f,
+    DdNode* g,
+    const vector<Int>& cubeVars,
+    Int cubeIndex,
+    const AbstractionWeights& weights,
+    vector<ProductAbstractionCache>& caches
+) {
+    if (cuddIsZero(manager, f)) return f;
+    if (cuddIsZero(manager, g)) return g;
+    if (cubeIndex == cubeVars.size()) return cuddAddApplyRecur(manager, cuddTimes(), f, g);  // unreferenced, as usual in CUDD
+    if (cuddIsConstant(f) && cuddIsConstant(g)) {
+        CUDD_VALUE_TYPE value = logCounting ? cuddV(f) + cuddV(g) : cuddV(f) * cuddV(g);
+        for (Int i = cubeIndex; i < cubeVars.size(); i++) {
+            CUDD_VALUE_TYPE sumWeight = cuddV(weights.sumWeightDds.at(cubeVars[i]).cuadd.getNode());
+            value = logCounting ? value + sumWeight : value * sumWeight;
+        }
+        return cuddUniqueConst(manager, value);
+    }
+    if (f > g) std::swap(f, g);  // the product commutes
+
+    ProductAbstractionCache& cache = caches[cubeIndex];
+    auto it = cache.find({f, g});
+    if (it != cache.end()) return it->second;
+
+    Int cubeVar = cubeVars[cubeIndex];
+    Int topLevel = std::min(cuddLevel(manager, f), cuddLevel(manager, g));
+    DdNode* result;
+    if (cuddI(manager, cubeVar) < topLevel) {  // neither factor depends on cubeVar
+        DdNode* rest = cuddWeightedProductAbstractRecur(manager, f, g, cubeVars, cubeIndex + 1, weights, caches);
+        if (rest == NULL) return NULL;
+        cuddRef(rest);
+        result = cuddAddApplyRecur(manager, cuddTimes(), rest, weights.sumWeightDds.at(cubeVar).cuadd.getNode());
+        if (result != NULL) cuddRef(result);
+        Cudd_RecursiveDeref(manager, rest);
+    } else {
+        DdNode *fLow = f, *fHigh = f, *gLow = g, *gHigh = g;
+        Int topIndex;
+        if (cuddLevel(manager, f) == topLevel) {
+            topIndex = f->index;
+            fLow = cuddE(f);
+            fHigh = cuddT(f);
+        }
+        if (cuddLevel(manager, g) == topLevel) {
+            topIndex = g->index;
+            gLow = cuddE(g);
+            gHigh = cuddT(g);
+        }
+        bool abstracting = topIndex == cubeVar;
+        Int childCubeIndex = abstracting ? cubeIndex + 1 : cubeIndex;
+        DdNode* high = cuddWeightedProductAbstractRecur(manager, fHigh, gHigh, cubeVars, childCubeIndex, weights, caches);
+        if (high == NULL) return NULL;
+        cuddRef(high);
+        DdNode* low = cuddWeightedProductAbstractRecur(manager, fLow, gLow, cubeVars, childCubeIndex, weights, caches);
+        if (low == NULL) {
+            Cudd_RecursiveDeref(manager, high);
+            return NULL;
+        }
+        cuddRef(low);
+        if (abstracting) {
+            result = cuddWeightedSum(manager, low, high, cubeVar, weights);
+        } else {
+            result = (high == low) ? high : cuddUniqueInter(manager, topIndex, high, low);
+            if (result != NULL) cuddRef(result);
+        }
+        Cudd_RecursiveDeref(manager, high);
+        Cudd_RecursiveDeref(manager, low);
+    }
+    if (result == NULL) return NULL;
+
+    cache.emplace(Pair<DdNode*, DdNode*>(f, g), result);  // keeps the reference taken above
+    return result;
+}
+
+static vector<Int> getCuddCubeVars(DdManager* manager, const Set<Int>& ddVars) {  // sorted by level
+    vector<Int> cubeVars(ddVars.begin(), ddVars.end());
+    std::sort(cubeVars.begin(), cubeVars.end(), [manager](Int ddVar1, Int ddVar2) {
+        return cuddI(manager, ddVar1) < cuddI(manager, ddVar2);
+    });
+    return cubeVars;
+}
+
+static Mtbdd getSylvanCube(const Set<Int>& ddVars) {
+    vector<uint32_t> cubeVars(ddVars.begin(), ddVars.end());
+    std::sort(cubeVars.begin(), cubeVars.end());
+    return Mtbdd(sylvan::mtbdd_set_from_array(cubeVars.data(), cubeVars.size()));
+}
+
 /* class Dd ================================================================= */
 
 size_t Dd::maxDdLeafCount;
 size_t Dd::maxDdNodeCount;
+std::map<string, Pair<size_t, size_t>> Dd::maxDdCounts;
+std::atomic<Int> Dd::parallelRegionCount(0);
 
 size_t Dd::prunedDdCount;
 Float Dd::pruningDuration;
@@ -23,6 +372,31 @@ size_t Dd::getNodeCount() const {
     return mtbdd.NodeCount();
 }
 
+// counting is a full traversal, so it only happens at named checkpoints and only when the counts are printed
+// Sylvan counts by marking nodes, which races with other Lace tasks building nodes, so checkpoints inside
+// parallel subtrees are skipped; the products after the outermost SYNC are still recorded
+void Dd::recordCounts(const string& checkpoint) const {
+    if (verbosityLevel < 2 || parallelRegionCount > 0) return;
+
+    size_t leafCount = getLeafCount();
+    size_t nodeCount = getNodeCount();
+
+    Pair<size_t, size_t>& maxCounts = maxDdCounts[checkpoint];
+    maxCounts.first = std::max(maxCounts.first, leafCount);
+    maxCounts.second = std::max(maxCounts.second, nodeCount);
+    maxDdLeafCount = std::max(maxDdLeafCount, leafCount);
+    maxDdNodeCount = std::max(maxDdNodeCount, nodeCount);
+}
+
+void Dd::printMaxCounts() {
+    util::printRow("maxDiagramLeaves", maxDdLeafCount);
+    util::printRow("maxDiagramNodes", maxDdNodeCount);
+    for (const auto& kv : maxDdCounts) {
+        util::printRow("maxDiagramLeaves@" + kv.first, kv.second.first);
+        util::printRow("maxDiagramNodes@" + kv.first, kv.second.second);
+    }
+}
+
 Dd::Dd(const ADD& cuadd) {
     assert(ddPackage == CUDD_PACKAGE);
     this->cuadd = cuadd;
@@ -39,9 +413,6 @@ Dd::Dd(const Dd& dd) {
     } else {
         *this = Dd(dd.mtbdd);
     }
-
-    maxDdLeafCount = std::max(maxDdLeafCount, getLeafCount());
-    maxDdNodeCount = std::max(maxDdNodeCount, getNodeCount());
 }
 
 Number Dd::extractConst() const {
@@ -51,6 +422,18 @@ Number Dd::extractConst() const {
         return Number(cuddV(minTerminal.getNode()));
     }
     assert(mtbdd.isLeaf());
+    if (ModularField::isActive()) {
+        return ModularField::extractNumber(mtbdd.GetMTBDD());
+    }
+    if (LaneLeaf::isActive()) {
+        return Number(LaneLeaf::getLanes(mtbdd.GetMTBDD()).front());
+    }
+    if (logCounting) {
+        return Number(LogLeaf::getLog10(mtbdd.GetMTBDD()));
+    }
+    if (TieredLeaf::isActive()) {
+        return Number(TieredLeaf::getQuotient(mtbdd.GetMTBDD()));
+    }
     if (multiplePrecision) {
         uint64_t val = mtbdd_getvalue(mtbdd.GetMTBDD());
         return Number(mpq_class(reinterpret_cast<mpq_ptr>(val)));
@@ -58,13 +441,34 @@ Number Dd::extractConst() const {
     return Number(mtbdd_getdouble(mtbdd.GetMTBDD()));
 }
 
+vector<Number> Dd::extractLanes() const {
+    if (ddPackage == CUDD_PACKAGE || !LaneLeaf::isActive()) return {extractConst()};
+    assert(mtbdd.isLeaf());
+    vector<Number> lanes;
+    for (Float lane : LaneLeaf::getLanes(mtbdd.GetMTBDD())) lanes.push_back(Number(lane));
+    return lanes;
+}
+
 Dd Dd::getConstDd(const Number& n, const Cudd& mgr) {
-    // No logCounting
+    if (logCounting && n < Number()) {
+        util::showError("log counting needs nonnegative weights, not " + to_string(n.fraction));
+    }
     if (ddPackage == CUDD_PACKAGE) {
-        // return logCounting ? Dd(mgr->constant(n.getLog10())) : Dd(mgr->constant(n.fraction));
-        return Dd(mgr.constant(n.fraction));
+        return logCounting ? Dd(mgr.constant(n.getLog10())) : Dd(mgr.constant(n.fraction));
     }
 
+    if (ModularField::isActive()) {
+        return Dd(Mtbdd(ModularField::getLeaf(n)));
+    }
+    if (LaneLeaf::isActive()) {
+        return Dd(Mtbdd(LaneLeaf::getLeaf(n.fraction)));
+    }
+    if (logCounting) {
+        return Dd(Mtbdd(LogLeaf::getLeaf(n.getLog10())));
+    }
+    if (TieredLeaf::isActive()) {
+        return Dd(Mtbdd(TieredLeaf::getLeaf(n.quotient)));
+    }
     if (multiplePrecision) {
         mpq_t q;  // C interface
         mpq_init(q);
@@ -103,10 +507,12 @@ Dd Dd::getVarDd(Int ddVar, const Cudd& mgr) {
 
 Dd Dd::getVarDd(Int ddVar, bool val, const Cudd& mgr) {
     if (ddPackage == CUDD_PACKAGE) {
-        // if (logCounting) {
-        //     return Dd(mgr->addLogVar(ddVar, val));
-        // }
         ADD d = mgr.addVar(ddVar);
+        if (logCounting) {  // leaves log10(1) and log10(0)
+            ADD one = getOneDd(mgr).cuadd;
+            ADD zero = getZeroDd(mgr).cuadd;
+            return val ? Dd(d.Ite(one, zero)) : Dd(d.Ite(zero, one));
+        }
         return val ? Dd(d) : Dd(d.Cmpl());
     }
     MTBDD d0 = getZeroDd(mgr).mtbdd.GetMTBDD();
@@ -114,6 +520,22 @@ Dd Dd::getVarDd(Int ddVar, bool val, const Cudd& mgr) {
     return val ? Dd(mtbdd_makenode(ddVar, d0, d1)) : Dd(mtbdd_makenode(ddVar, d1, d0));
 }
 
+// makes the node directly, without the apply of getVarDd(ddVar).getIte(high, low)
+Dd Dd::getNode(Int ddVar, const Dd& high, const Dd& low, const Cudd& mgr) {
+    if (ddPackage == CUDD_PACKAGE) {
+        DdNode* highNode = high.cuadd.getNode();
+        DdNode* lowNode = low.cuadd.getNode();
+        if (highNode == lowNode) return high;
+
+        DdNode* node = cuddUniqueInter(mgr.getManager(), ddVar, highNode, lowNode);  // children are referenced by their ADDs
+        if (node == NULL) {
+            util::showError("CUDD failed to make node for var " + to_string(ddVar));
+        }
+        return Dd(ADD(mgr, node));
+    }
+    return Dd(Mtbdd(mtbdd_makenode(ddVar, low.mtbdd.GetMTBDD(), high.mtbdd.GetMTBDD())));
+}
+
 bool Dd::operator!=(const Dd& rightDd) const {
     if (ddPackage == CUDD_PACKAGE) {
         return cuadd != rightDd.cuadd;
@@ -135,8 +557,23 @@ Dd Dd::getComposition(Int ddVar, bool val, const Cudd& mgr) const {
 
 Dd Dd::getProduct(const Dd& dd) const {
     if (ddPackage == CUDD_PACKAGE) {
-        // return logCounting ? Dd(cuadd + dd.cuadd) : Dd(cuadd * dd.cuadd);
-        return Dd(cuadd * dd.cuadd);
+        return logCounting ? Dd(cuadd + dd.cuadd) : Dd(cuadd * dd.cuadd);
+    }
+    if (ModularField::isActive()) {
+        LACE_ME;
+        return Dd(Mtbdd(modular_times(mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD())));
+    }
+    if (LaneLeaf::isActive()) {
+        LACE_ME;
+        return Dd(Mtbdd(lane_times(mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD())));
+    }
+    if (logCounting) {
+        LACE_ME;
+        return Dd(Mtbdd(log_times(mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD())));
+    }
+    if (TieredLeaf::isActive()) {
+        LACE_ME;
+        return Dd(Mtbdd(tiered_times(mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD())));
     }
     if (multiplePrecision) {
         LACE_ME;
@@ -145,11 +582,33 @@ Dd Dd::getProduct(const Dd& dd) const {
     return Dd(mtbdd * dd.mtbdd);
 }
 
-Dd Dd::getSum(const Dd& dd) const {
+Dd Dd::getSum(const Dd& dd, const Cudd& mgr) const {
     if (ddPackage == CUDD_PACKAGE) {
-        // return logCounting ? Dd(cuadd.LogSumExp(dd.cuadd)) : Dd(cuadd + dd.cuadd);
+        if (logCounting) {
+            DdNode* node = Cudd_addApply(mgr.getManager(), cuddAddLogSumExp, cuadd.getNode(), dd.cuadd.getNode());
+            if (node == NULL) {
+                util::showError("CUDD failed during log-sum-exp");
+            }
+            return Dd(ADD(mgr, node));
+        }
         return Dd(cuadd + dd.cuadd);
     }
+    if (ModularField::isActive()) {
+        LACE_ME;
+        return Dd(Mtbdd(modular_plus(mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD())));
+    }
+    if (LaneLeaf::isActive()) {
+        LACE_ME;
+        return Dd(Mtbdd(lane_plus(mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD())));
+    }
+    if (logCounting) {
+        LACE_ME;
+        return Dd(Mtbdd(log_plus(mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD())));
+    }
+    if (TieredLeaf::isActive()) {
+        LACE_ME;
+        return Dd(Mtbdd(tiered_plus(mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD())));
+    }
     if (multiplePrecision) {
         LACE_ME;
         return Dd(Mtbdd(gmp_plus(mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD())));
@@ -161,6 +620,21 @@ Dd Dd::getMax(const Dd& dd) const {
     if (ddPackage == CUDD_PACKAGE) {
         return Dd(cuadd.Maximum(dd.cuadd));
     }
+    if (ModularField::isActive()) {
+        util::showError("residues have no order, so modular counting cannot take maxima");
+    }
+    if (LaneLeaf::isActive()) {
+        LACE_ME;
+        return Dd(Mtbdd(lane_max(mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD())));
+    }
+    if (logCounting) {
+        LACE_ME;
+        return Dd(Mtbdd(log_max(mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD())));
+    }
+    if (TieredLeaf::isActive()) {
+        LACE_ME;
+        return Dd(Mtbdd(tiered_max(mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD())));
+    }
     if (multiplePrecision) {
         LACE_ME;
         return Dd(Mtbdd(gmp_max(mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD())));
@@ -181,6 +655,65 @@ Dd Dd::getIte(Dd& tdd, Dd& fdd) const {
     return Dd(mtbdd.Ite(tdd.mtbdd, fdd.mtbdd));
 }
 
+Dd Dd::getAbstraction(
+    const Set<Int>& ddVars,
+    const vector<Int>& ddVarToCnfVarMap,
+    const Map<Int, Number>& literalWeights,
+    const Cudd& mgr
+) const {
+    if (ddVars.empty()) return *this;
+
+    AbstractionWeights weights = getAbstractionWeights(ddVars, ddVarToCnfVarMap, literalWeights, mgr);
+    if (ddPackage == CUDD_PACKAGE) {
+        DdManager* manager = mgr.getManager();
+        AbstractionCache cache;
+        DdNode* node = cuddWeightedAbstractRecur(manager, cuadd.getNode(), getCuddCubeVars(manager, ddVars), 0, weights, cache);
+        if (node == NULL) {
+            util::showError("CUDD failed during weighted abstraction");
+        }
+        Dd abstraction(ADD(mgr, node));  // references node before the cache releases it
+        for (const auto& entry : cache) {
+            Cudd_RecursiveDeref(manager, entry.second);
+        }
+        return abstraction;
+    }
+
+    Mtbdd cube = getSylvanCube(ddVars);
+    LACE_ME;
+    return Dd(Mtbdd(CALL(weightedAbstractTask, mtbdd.GetMTBDD(), cube.GetMTBDD(), &weights)));
+}
+
+Dd Dd::getProductAbstraction(
+    const Dd& dd,
+    const Set<Int>& ddVars,
+    const vector<Int>& ddVarToCnfVarMap,
+    const Map<Int, Number>& literalWeights,
+    const Cudd& mgr
+) const {
+    if (ddVars.empty()) return getProduct(dd);
+
+    AbstractionWeights weights = getAbstractionWeights(ddVars, ddVarToCnfVarMap, literalWeights, mgr);
+    if (ddPackage == CUDD_PACKAGE) {
+        DdManager* manager = mgr.getManager();
+        vector<ProductAbstractionCache> caches(ddVars.size());
+        DdNode* node = cuddWeightedProductAbstractRecur(manager, cuadd.getNode(), dd.cuadd.getNode(), getCuddCubeVars(manager, ddVars), 0, weights, caches);
+        if (node == NULL) {
+            util::showError("CUDD failed during weighted product abstraction");
+        }
+        Dd abstraction(ADD(mgr, node));  // references node before the caches release it
+        for (const ProductAbstractionCache& cache : caches) {
+            for (const auto& entry : cache) {
+                Cudd_RecursiveDeref(manager, entry.second);
+            }
+        }
+        return abstraction;
+    }
+
+    Mtbdd cube = getSylvanCube(ddVars);
+    LACE_ME;
+    return Dd(Mtbdd(CALL(weightedProductAbstractTask, mtbdd.GetMTBDD(), dd.mtbdd.GetMTBDD(), cube.GetMTBDD(), &weights)));
+}
+
 Set<Int> Dd::getSupport() const {
     Set<Int> support;
     if (ddPackage == CUDD_PACKAGE) {
@@ -208,6 +741,47 @@ bool Dd::evalAssignment(vector<int>& ddVarAssignment) const {
     return n == Number(1);
 }
 
+Int Dd::getDecisionNodes(vector<Int>& nodeDdVars, vector<Int>& highIds, vector<Int>& lowIds, const Cudd& mgr) const {
+    bool cudd = ddPackage == CUDD_PACKAGE;
+    auto getHandle = [cudd](const Dd& dd) { return cudd ? reinterpret_cast<uintptr_t>(dd.cuadd.getNode()) : uintptr_t(dd.mtbdd.GetMTBDD()); };
+    auto getCuddNode = [](uintptr_t handle) { return reinterpret_cast<DdNode*>(handle); };
+
+    Map<uintptr_t, Int> ids = {{getHandle(getZeroDd(mgr)), 0}, {getHandle(getOneDd(mgr)), 1}};  // leaves are unique, so this covers every leaf type
+    if (!cudd) {  // Boolean leaves of Sylvan, as left by getComposition
+        ids.emplace(sylvan::mtbdd_false, 0);
+        ids.emplace(sylvan::mtbdd_true, 1);
+    }
+    uintptr_t root = getHandle(*this);
+    vector<uintptr_t> stack = {root};  // iterative, since paths are as long as the var order
+    while (!stack.empty()) {
+        uintptr_t node = stack.back();
+        if (ids.count(node) > 0) {
+            stack.pop_back();
+            continue;
+        }
+        if (cudd ? cuddIsConstant(getCuddNode(node)) : mtbdd_isleaf(node)) {
+            util::showError("only a 0-1 diagram has decision nodes");
+        }
+        uintptr_t high = cudd ? reinterpret_cast<uintptr_t>(cuddT(getCuddNode(node))) : uintptr_t(mtbdd_gethigh(node));
+        uintptr_t low = cudd ? reinterpret_cast<uintptr_t>(cuddE(getCuddNode(node))) : uintptr_t(mtbdd_getlow(node));
+        bool childrenDone = true;
+        for (uintptr_t child : {high, low}) {
+            if (ids.count(child) == 0) {
+                stack.push_back(child);
+                childrenDone = false;
+            }
+        }
+        if (!childrenDone) continue;
+
+        stack.pop_back();
+        ids[node] = nodeDdVars.size() + 2;
+        nodeDdVars.push_back(cudd ? Int(getCuddNode(node)->index) : Int(mtbdd_getvar(node)));
+        highIds.push_back(ids.at(high));
+        lowIds.push_back(ids.at(low));
+    }
+    return ids.at(root);
+}
+
 Int Dd::getTopVar() const {
     assert(ddPackage == SYLVAN_PACKAGE);
     return mtbdd.TopVar();
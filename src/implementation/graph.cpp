@@ -16,69 +16,359 @@ void Graph::printVertices() const {
 
 void Graph::printAdjacencyMap() const {
   cout << "adjacency map {\n";
-  for (auto pair = adjacencyMap.begin(); pair != adjacencyMap.end(); pair++) {
-    auto vertex = pair->first;
-    auto neighbors = pair->second;
-    cout << "\t" << vertex << " : ";
-    for (auto neighbor = neighbors.begin(); neighbor != neighbors.end(); neighbor++) {
-      cout << *neighbor << " ";
+  for (Int v = 0; v < getVertexCount(); v++) {
+    cout << "\t" << vertices[v] << " : ";
+    for (auto n = beginNeighbors(v); n != endNeighbors(v); n++) {
+      cout << vertices[*n] << " ";
     }
     cout << "\n";
   }
   cout << "}\n\n";
 }
 
-Graph::Graph(const Set<Int> &cnfVars) {
-  vertices = cnfVars;
-  for (Int cnfVar : cnfVars) {
-    adjacencyMap[cnfVar] = Set<Int>();
+Graph::Graph(const vector<Int> &vars, const vector<vector<Int>> &cliques) {
+  vertices = vars;
+  Int vertexCount = vertices.size();
+  for (Int v = 0; v < vertexCount; v++) {
+    vertexIds[vertices[v]] = v;
   }
+
+  vector<Int> degrees(vertexCount + 1, 0); // upper bounds before duplicates are dropped
+  for (const vector<Int> &clique : cliques) {
+    for (Int var : clique) {
+      degrees[vertexIds.at(var)] += clique.size() - 1;
+    }
+  }
+  offsets.assign(vertexCount + 1, 0);
+  for (Int v = 0; v < vertexCount; v++) {
+    offsets[v + 1] = offsets[v] + degrees[v];
+  }
+  neighbors.assign(offsets[vertexCount], 0);
+  vector<Int> ends(offsets.begin(), offsets.end() - 1);
+  for (const vector<Int> &clique : cliques) {
+    for (auto var1 = clique.begin(); var1 != clique.end(); var1++) {
+      for (auto var2 = std::next(var1); var2 != clique.end(); var2++) {
+        Int v1 = vertexIds.at(*var1);
+        Int v2 = vertexIds.at(*var2);
+        if (v1 == v2) continue;
+        neighbors[ends[v1]++] = v2;
+        neighbors[ends[v2]++] = v1;
+      }
+    }
+  }
+
+  Int size = 0; // compacts the rows in place
+  for (Int v = 0; v < vertexCount; v++) {
+    auto rowBegin = neighbors.begin() + offsets[v];
+    auto rowEnd = neighbors.begin() + ends[v];
+    std::sort(rowBegin, rowEnd);
+    rowEnd = std::unique(rowBegin, rowEnd);
+    offsets[v] = size;
+    for (auto n = rowBegin; n != rowEnd; n++) {
+      neighbors[size++] = *n;
+    }
+  }
+  offsets[vertexCount] = size;
+  neighbors.resize(size);
+  neighbors.shrink_to_fit();
+}
+
+Int Graph::getVertexCount() const {
+  return vertices.size();
 }
 
-void Graph::addEdge(Int cnfVar1, Int cnfVar2) {
-  adjacencyMap.at(cnfVar1).insert(cnfVar2);
-  adjacencyMap.at(cnfVar2).insert(cnfVar1);
+Int Graph::getVertex(Int id) const {
+  return vertices[id];
 }
 
-Set<Int>::const_iterator Graph::beginVertices() const {
-  return vertices.begin();
+Int Graph::getVertexId(Int var) const {
+  return vertexIds.at(var);
 }
 
-Set<Int>::const_iterator Graph::endVertices() const {
-  return vertices.end();
+Int Graph::getDegree(Int id) const {
+  return offsets[id + 1] - offsets[id];
 }
 
-Set<Int>::const_iterator Graph::beginNeighbors(Int cnfVar) {
-  return adjacencyMap.at(cnfVar).begin();
+const Int *Graph::beginNeighbors(Int id) const {
+  return neighbors.data() + offsets[id];
 }
 
-Set<Int>::const_iterator Graph::endNeighbors(Int cnfVar) {
-  return adjacencyMap.at(cnfVar).end();
+const Int *Graph::endNeighbors(Int id) const {
+  return neighbors.data() + offsets[id + 1];
 }
 
-void Graph::removeVertex(Int v) {
-  vertices.erase(v);
+// unnumbered vertices grouped by equal label, highest label first: numbering v moves each unnumbered neighbor of v
+// into a new class just above its own, which is the label refinement of Lex-BFS at O(1) per moved vertex
+// vertices enter every class in increasing id order, so the head of the first class has the smallest id of the max label
+class LabelClasses {
+  vector<Int> classIds;                  // vertex id |-> class
+  vector<Int> prevIds, nextIds;          // vertex id |-> neighbor in its class, -1 at the ends
+  vector<Int> heads, tails;              // class |-> first and last vertex
+  vector<Int> prevClasses, nextClasses;  // class |-> neighbor in the class list, -1 at the ends
+  vector<Int> raisedClasses;             // class |-> class created above it by the current refinement
+  vector<Int> refinementStamps;          // class |-> refinement that created raisedClasses[class]
+  Int firstClass = -1;
+  Int refinementIndex = 0;
+
+  Int addClass() {
+    heads.push_back(-1);
+    tails.push_back(-1);
+    prevClasses.push_back(-1);
+    nextClasses.push_back(-1);
+    raisedClasses.push_back(-1);
+    refinementStamps.push_back(-1);
+    return heads.size() - 1;
+  }
+
+  void appendVertex(Int v, Int c) {
+    classIds[v] = c;
+    prevIds[v] = tails[c];
+    nextIds[v] = -1;
+    if (tails[c] < 0) heads[c] = v;
+    else nextIds[tails[c]] = v;
+    tails[c] = v;
+  }
+
+  void removeVertex(Int v) { // an emptied class leaves the class list
+    Int c = classIds[v];
+    if (prevIds[v] < 0) heads[c] = nextIds[v];
+    else nextIds[prevIds[v]] = nextIds[v];
+    if (nextIds[v] < 0) tails[c] = prevIds[v];
+    else prevIds[nextIds[v]] = prevIds[v];
+    if (heads[c] >= 0) return;
 
-  adjacencyMap.erase(v); // edges from v
+    if (prevClasses[c] < 0) firstClass = nextClasses[c];
+    else nextClasses[prevClasses[c]] = nextClasses[c];
+    if (nextClasses[c] >= 0) prevClasses[nextClasses[c]] = prevClasses[c];
+  }
+
+public:
+  LabelClasses(Int vertexCount) : classIds(vertexCount), prevIds(vertexCount), nextIds(vertexCount) {
+    if (vertexCount == 0) return;
+    firstClass = addClass();
+    for (Int v = 0; v < vertexCount; v++) appendVertex(v, firstClass);
+  }
+
+  Int popMaxLabelVertex() {
+    Int v = heads[firstClass];
+    removeVertex(v);
+    return v;
+  }
+
+  void beginRefinement() { refinementIndex++; }
+
+  void raise(Int v) { // moves v into the class just above its current one, shared by the vertices of this refinement
+    Int c = classIds[v];
+    if (refinementStamps[c] != refinementIndex) {
+      Int raisedClass = addClass();
+      refinementStamps[c] = refinementIndex;
+      raisedClasses[c] = raisedClass;
+      prevClasses[raisedClass] = prevClasses[c];
+      nextClasses[raisedClass] = c;
+      if (prevClasses[c] < 0) firstClass = raisedClass;
+      else nextClasses[prevClasses[c]] = raisedClass;
+      prevClasses[c] = raisedClass;
+    }
+    Int raisedClass = raisedClasses[c];
+    removeVertex(v);
+    appendVertex(v, raisedClass);
+  }
+
+  Int getRanks(vector<Int> &labels) const { // labels of unnumbered vertices become class ranks, 0 for the lowest; returns the class count
+    Int classCount = 0;
+    for (Int c = firstClass; c >= 0; c = nextClasses[c]) classCount++;
+    Int rank = classCount;
+    for (Int c = firstClass; c >= 0; c = nextClasses[c]) {
+      rank--;
+      for (Int v = heads[c]; v >= 0; v = nextIds[v]) labels[v] = rank;
+    }
+    return std::max(classCount, Int(1));
+  }
+};
 
-  for (std::pair<const Int, Set<Int>> &vertexAndNeighbors: adjacencyMap)
-    vertexAndNeighbors.second.erase(v); // edges to v
+/* partition refinement, so O(n + m) */
+vector<Int> Graph::getLexpOrdering() const {
+  Int vertexCount = getVertexCount();
+  LabelClasses labelClasses(vertexCount);
+  vector<bool> numbered(vertexCount, false);
+
+  vector<Int> numberedVertices; // whose \alpha numbers are decreasing
+  for (Int number = vertexCount; number > 0; number--) {
+    Int v = labelClasses.popMaxLabelVertex();
+    numbered[v] = true;
+    numberedVertices.push_back(vertices[v]);
+
+    labelClasses.beginRefinement();
+    for (auto n = beginNeighbors(v); n != endNeighbors(v); n++) { // rows are sorted, so raised classes stay sorted by id
+      if (!numbered[*n]) labelClasses.raise(*n);
+    }
+  }
+  return numberedVertices;
 }
 
-bool Graph::hasPath(Int from, Int to, Set<Int> &visitedVertices) const {
-  if (from == to) return true;
+/* Rose, Tarjan, Lueker: each number costs one search over the unnumbered subgraph, so the ordering takes O(n * m) */
+vector<Int> Graph::getLexmOrdering() const {
+  Int vertexCount = getVertexCount();
+  LabelClasses labelClasses(vertexCount);
+  vector<Int> labels(vertexCount, 0);
+  vector<bool> numbered(vertexCount, false), reached(vertexCount);
+  vector<Int> updatedIds;
+  vector<vector<Int>> reach; // label rank |-> reached vertices still to be searched from
 
-  visitedVertices.insert(from);
+  vector<Int> numberedVertices; // whose \alpha numbers are decreasing
+  for (Int number = vertexCount; number > 0; number--) {
+    Int v = labelClasses.popMaxLabelVertex();
+    numbered[v] = true;
+    numberedVertices.push_back(vertices[v]);
+    Int labelCount = labelClasses.getRanks(labels);
 
-  Set<Int> unvisitedNeighbors;
-  util::differ(unvisitedNeighbors, adjacencyMap.at(from), visitedVertices);
+    /* numbers each unnumbered w having a path from v whose inner vertices have labels less than w's: */
+    std::fill(reached.begin(), reached.end(), false);
+    updatedIds.clear();
+    reach.assign(labelCount, vector<Int>());
+    for (auto n = beginNeighbors(v); n != endNeighbors(v); n++) {
+      Int w = *n;
+      if (!numbered[w]) {
+        reached[w] = true;
+        updatedIds.push_back(w);
+        reach[labels[w]].push_back(w);
+      }
+    }
+    for (Int j = 0; j < labelCount; j++) {
+      while (!reach[j].empty()) {
+        Int w = reach[j].back();
+        reach[j].pop_back();
+        for (auto n = beginNeighbors(w); n != endNeighbors(w); n++) {
+          Int z = *n;
+          if (numbered[z] || reached[z]) continue;
+          reached[z] = true;
+          if (labels[z] > j) {
+            updatedIds.push_back(z);
+            reach[labels[z]].push_back(z);
+          } else {
+            reach[j].push_back(z);
+          }
+        }
+      }
+    }
+
+    std::sort(updatedIds.begin(), updatedIds.end()); // raised classes stay sorted by id
+    labelClasses.beginRefinement();
+    for (Int w : updatedIds) labelClasses.raise(w);
+  }
+  return numberedVertices;
+}
+
+/* buckets of unranked vertices by ranked-neighbor count, with stale entries skipped lazily, so O(n + m) */
+vector<Int> Graph::getMcsOrdering() const {
+  Int vertexCount = getVertexCount();
+  vector<Int> rankedNeighborCounts(vertexCount, 0);
+  vector<bool> ranked(vertexCount, false);
+  vector<vector<Int>> buckets(1); // ranked-neighbor count |-> unranked vertices
+  for (Int v = vertexCount - 1; v >= 0; v--) {
+    buckets[0].push_back(v); // smaller ids first among vertices with no ranked neighbor; other buckets are LIFO
+  }
+
+  vector<Int> varOrdering;
+  Int bestCount = 0;
+  while (varOrdering.size() < vertexCount) {
+    while (buckets[bestCount].empty()) bestCount--;
+    Int v = buckets[bestCount].back();
+    buckets[bestCount].pop_back();
+    if (ranked[v] || rankedNeighborCounts[v] != bestCount) continue;
 
-  for (Int v : unvisitedNeighbors) if (hasPath(v, to, visitedVertices)) return true;
+    ranked[v] = true;
+    varOrdering.push_back(vertices[v]);
+    for (auto n = beginNeighbors(v); n != endNeighbors(v); n++) {
+      if (ranked[*n]) continue;
+      Int count = ++rankedNeighborCounts[*n];
+      if (count == buckets.size()) buckets.emplace_back();
+      buckets[count].push_back(*n);
+      bestCount = std::max(bestCount, count);
+    }
+  }
+  return varOrdering;
+}
+
+static Int getEliminationCostValue(Int v, EliminationCost eliminationCost, const vector<Set<Int>> &adjacencySets) {
+  const Set<Int> &neighbors = adjacencySets[v];
+  if (eliminationCost == EliminationCost::DEGREE) return neighbors.size();
 
-  return false;
+  Int cost = 0;
+  for (auto n1 = neighbors.begin(); n1 != neighbors.end(); n1++) {
+    const Set<Int> &neighbors1 = adjacencySets[*n1];
+    for (auto n2 = std::next(n1); n2 != neighbors.end(); n2++) {
+      if (!util::isFound(*n2, neighbors1)) {
+        cost += eliminationCost == EliminationCost::FILL ? 1 : neighbors1.size() * adjacencySets[*n2].size();
+      }
+    }
+  }
+  return cost;
 }
 
-bool Graph::hasPath(Int from, Int to) const {
-  Set<Int> visitedVertices;
-  return hasPath(from, to, visitedVertices);
+// removes v and makes its neighbors a clique
+static void eliminateVertex(Int v, vector<Set<Int>> &adjacencySets) {
+  const Set<Int> &neighbors = adjacencySets[v];
+  for (Int n1 : neighbors) {
+    Set<Int> &neighbors1 = adjacencySets[n1];
+    neighbors1.erase(v);
+    for (Int n2 : neighbors) {
+      if (n1 != n2) neighbors1.insert(n2);
+    }
+  }
+  adjacencySets[v].clear();
+}
+
+// the elimination heuristics add fill edges, so they work on a mutable copy
+static vector<Set<Int>> getAdjacencySets(const Graph &graph) {
+  vector<Set<Int>> adjacencySets(graph.getVertexCount());
+  for (Int v = 0; v < graph.getVertexCount(); v++) {
+    adjacencySets[v].insert(graph.beginNeighbors(v), graph.endNeighbors(v));
+  }
+  return adjacencySets;
+}
+
+// the ordering is built by eliminating, so its induced width comes for free
+vector<Int> Graph::getEliminationOrdering(EliminationCost eliminationCost, Int &inducedWidth) const {
+  vector<Set<Int>> remainingAdjacencySets = getAdjacencySets(*this);
+  vector<Int> costs(getVertexCount());
+  std::set<Pair<Int, Int>> queue; // (cost, id), cheapest first
+  for (Int v = 0; v < getVertexCount(); v++) {
+    costs[v] = getEliminationCostValue(v, eliminationCost, remainingAdjacencySets);
+    queue.insert({costs[v], v});
+  }
+
+  vector<Int> eliminationOrdering;
+  inducedWidth = 0;
+  while (!queue.empty()) {
+    Int v = queue.begin()->second;
+    queue.erase(queue.begin());
+    eliminationOrdering.push_back(vertices[v]);
+    inducedWidth = std::max(inducedWidth, Int(remainingAdjacencySets[v].size()));
+
+    Set<Int> affectedVertices = remainingAdjacencySets[v]; // the degree changes only for neighbors
+    eliminateVertex(v, remainingAdjacencySets);
+    if (eliminationCost != EliminationCost::DEGREE) { // the fill also changes for neighbors of neighbors
+      Set<Int> neighbors = affectedVertices;
+      for (Int n : neighbors) util::unionize(affectedVertices, remainingAdjacencySets[n]);
+    }
+
+    for (Int u : affectedVertices) {
+      queue.erase({costs[u], u});
+      costs[u] = getEliminationCostValue(u, eliminationCost, remainingAdjacencySets);
+      queue.insert({costs[u], u});
+    }
+  }
+  return eliminationOrdering;
+}
+
+Int Graph::getInducedWidth(const vector<Int> &eliminationOrdering) const {
+  vector<Set<Int>> remainingAdjacencySets = getAdjacencySets(*this);
+  Int inducedWidth = 0;
+  for (Int var : eliminationOrdering) {
+    Int v = getVertexId(var);
+    inducedWidth = std::max(inducedWidth, Int(remainingAdjacencySets[v].size()));
+    eliminateVertex(v, remainingAdjacencySets);
+  }
+  return inducedWidth;
 }
@@ -0,0 +1,182 @@
+/* inclusions *****************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+
+#include "../interface/laneLeaf.hpp"
+
+/* uses ***********************************************************************/
+
+using sylvan::MTBDD;
+using util::showError;
+
+/* helpers ********************************************************************/
+
+static size_t getLeafSize() {
+    return LaneLeaf::laneCount * sizeof(Float);
+}
+
+static const Float* getLaneValues(MTBDD leaf) {
+    return reinterpret_cast<const Float*>(sylvan::mtbdd_getvalue(leaf));
+}
+
+/* Sylvan leaf callbacks ******************************************************/
+
+static uint64_t hashLeaf(uint64_t value, uint64_t seed) {
+    const Float* lanes = reinterpret_cast<const Float*>(value);
+    uint64_t hash = seed ^ 14695981039346656037ULL;
+    for (Int i = 0; i < LaneLeaf::laneCount; i++) {
+        uint64_t word;
+        memcpy(&word, lanes + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+static int equalLeaves(uint64_t left, uint64_t right) {
+    return memcmp(reinterpret_cast<const void*>(left), reinterpret_cast<const void*>(right), getLeafSize()) == 0;
+}
+
+// Sylvan passes the caller's temporary array, to be replaced by a copy the leaf owns
+static void createLeaf(uint64_t* value) {
+    void* copy = malloc(getLeafSize());
+    memcpy(copy, reinterpret_cast<const void*>(*value), getLeafSize());
+    *value = reinterpret_cast<uint64_t>(copy);
+}
+
+static void destroyLeaf(uint64_t value) {
+    free(reinterpret_cast<void*>(value));
+}
+
+// a value shared by all lanes prints as itself, so 0-1 diagrams still read "0" and "1"
+static char* leafToString(int complemented, uint64_t value, char* buf, size_t bufsize) {
+    const Float* lanes = reinterpret_cast<const Float*>(value);
+    std::ostringstream stream;
+    bool uniform = std::all_of(lanes, lanes + LaneLeaf::laneCount, [lanes](Float lane) { return lane == lanes[0]; });
+    if (uniform) {
+        stream << lanes[0];
+    } else {
+        for (Int i = 0; i < LaneLeaf::laneCount; i++) stream << (i == 0 ? "[" : " ") << lanes[i];
+        stream << "]";
+    }
+    string s = stream.str();
+    if (s.size() < bufsize) {
+        memcpy(buf, s.c_str(), s.size() + 1);
+        return buf;
+    }
+    return strdup(s.c_str());
+}
+
+/* class LaneLeaf *************************************************************/
+
+static uint32_t laneLeafType;
+
+bool LaneLeaf::typeInitialized = false;
+Map<Int, vector<Float>> LaneLeaf::literalLanes;
+Int LaneLeaf::laneCount = 0;
+
+void LaneLeaf::initLeafType() {
+    laneLeafType = sylvan::sylvan_mt_create_type();
+    sylvan::sylvan_mt_set_hash(laneLeafType, hashLeaf);
+    sylvan::sylvan_mt_set_equals(laneLeafType, equalLeaves);
+    sylvan::sylvan_mt_set_create(laneLeafType, createLeaf);
+    sylvan::sylvan_mt_set_destroy(laneLeafType, destroyLeaf);
+    sylvan::sylvan_mt_set_to_str(laneLeafType, leafToString);
+    typeInitialized = true;
+}
+
+void LaneLeaf::init(const vector<Map<Int, Number>>& laneWeights) {
+    if (!typeInitialized) showError("lane leaves need the Sylvan Package with double leaves");
+    if (laneCount != 0 && laneCount != laneWeights.size()) {  // live leaves have the old length
+        showError("lane count changed from " + to_string(laneCount) + " to " + to_string(laneWeights.size()));
+    }
+    laneCount = laneWeights.size();
+    literalLanes.clear();
+    for (Int lane = 0; lane < laneCount; lane++) {
+        for (const auto& kv : laneWeights[lane]) {
+            vector<Float>& lanes = literalLanes[kv.first];
+            lanes.resize(laneCount);
+            lanes[lane] = kv.second.fraction;
+        }
+    }
+}
+
+MTBDD LaneLeaf::getLeaf(const vector<Float>& lanes) {
+    if (std::all_of(lanes.begin(), lanes.end(), [](Float lane) { return lane == 0; })) return sylvan::mtbdd_false;
+    return sylvan::mtbdd_makeleaf(laneLeafType, reinterpret_cast<uint64_t>(lanes.data()));
+}
+
+MTBDD LaneLeaf::getLeaf(Float value) {
+    return getLeaf(vector<Float>(laneCount, value));
+}
+
+const vector<Float>& LaneLeaf::getLiteralLanes(Int literal) {
+    return literalLanes.at(literal);
+}
+
+vector<Float> LaneLeaf::getLanes(MTBDD leaf) {
+    if (leaf == sylvan::mtbdd_false) return vector<Float>(laneCount, 0);
+    const Float* lanes = getLaneValues(leaf);
+    return vector<Float>(lanes, lanes + laneCount);
+}
+
+/* Lace tasks *****************************************************************/
+
+// a straight loop over restrict pointers with op inlined, so the compiler vectorizes each lane operation
+template <typename Op>
+static MTBDD applyLanes(MTBDD a, MTBDD b, Op op) {
+    thread_local vector<Float> result;
+    result.resize(LaneLeaf::laneCount);
+    const Float* __restrict left = getLaneValues(a);
+    const Float* __restrict right = getLaneValues(b);
+    Float* __restrict out = result.data();
+#pragma GCC ivdep
+    for (Int i = 0; i < LaneLeaf::laneCount; i++) out[i] = op(left[i], right[i]);
+    return LaneLeaf::getLeaf(result);
+}
+
+static Float laneTimes(Float x, Float y) { return x * y; }
+static Float lanePlus(Float x, Float y) { return x + y; }
+static Float laneMax(Float x, Float y) { return x < y ? y : x; }
+static Float laneMaxZero(Float x, Float) { return x < 0 ? 0 : x; }
+
+// mtbdd_false is the zero vector; operands are swapped into a canonical order for the operation cache
+TASK_IMPL_2(MTBDD, lane_op_times, MTBDD*, pa, MTBDD*, pb) {
+    MTBDD a = *pa, b = *pb;
+    if (a == sylvan::mtbdd_false || b == sylvan::mtbdd_false) return sylvan::mtbdd_false;
+    if (sylvan::mtbdd_isleaf(a) && sylvan::mtbdd_isleaf(b)) return applyLanes(a, b, laneTimes);
+    if (a > b) {
+        *pa = b;
+        *pb = a;
+    }
+    return sylvan::mtbdd_invalid;
+}
+
+TASK_IMPL_2(MTBDD, lane_op_plus, MTBDD*, pa, MTBDD*, pb) {
+    MTBDD a = *pa, b = *pb;
+    if (a == sylvan::mtbdd_false) return b;
+    if (b == sylvan::mtbdd_false) return a;
+    if (sylvan::mtbdd_isleaf(a) && sylvan::mtbdd_isleaf(b)) return applyLanes(a, b, lanePlus);
+    if (a > b) {
+        *pa = b;
+        *pb = a;
+    }
+    return sylvan::mtbdd_invalid;
+}
+
+// lane by lane, so the result may equal neither operand
+TASK_IMPL_2(MTBDD, lane_op_max, MTBDD*, pa, MTBDD*, pb) {
+    MTBDD a = *pa, b = *pb;
+    if (a == b) return a;
+    if (sylvan::mtbdd_isleaf(a) && sylvan::mtbdd_isleaf(b)) {
+        if (a == sylvan::mtbdd_false) return applyLanes(b, b, laneMaxZero);
+        if (b == sylvan::mtbdd_false) return applyLanes(a, a, laneMaxZero);
+        return applyLanes(a, b, laneMax);
+    }
+    if (a > b) {
+        *pa = b;
+        *pb = a;
+    }
+    return sylvan::mtbdd_invalid;
+}
@@ -0,0 +1,94 @@
+/* inclusions *****************************************************************/
+
+#include <cstring>
+
+#include "../interface/logLeaf.hpp"
+
+/* uses ***********************************************************************/
+
+using sylvan::MTBDD;
+
+/* Sylvan leaf callbacks ******************************************************/
+
+// the linear value, so "1" reads as usual; other values as powers of ten, which may exceed a double
+static char* leafToString(int complemented, uint64_t value, char* buf, size_t bufsize) {
+    Float log10Value;
+    memcpy(&log10Value, &value, sizeof(Float));
+    string s = log10Value == 0 ? "1" : "10^" + to_string(log10Value);
+    if (s.size() < bufsize) {
+        memcpy(buf, s.c_str(), s.size() + 1);
+        return buf;
+    }
+    return strdup(s.c_str());
+}
+
+/* class LogLeaf **************************************************************/
+
+uint32_t LogLeaf::leafType;
+
+// values are plain bits, so Sylvan's default hash and equality suffice and leaves own no memory
+void LogLeaf::initLeafType() {
+    leafType = sylvan::sylvan_mt_create_type();
+    sylvan::sylvan_mt_set_to_str(leafType, leafToString);
+}
+
+MTBDD LogLeaf::getLeaf(Float log10Value) {
+    if (log10Value == NEGATIVE_INFINITY) return sylvan::mtbdd_false;  // the only zero
+    if (log10Value == 0) log10Value = 0;  // -0.0 and 0.0 must share a leaf
+    uint64_t value;
+    memcpy(&value, &log10Value, sizeof(Float));
+    return sylvan::mtbdd_makeleaf(leafType, value);
+}
+
+Float LogLeaf::getLog10(MTBDD leaf) {
+    if (leaf == sylvan::mtbdd_false) return NEGATIVE_INFINITY;
+    uint64_t value = sylvan::mtbdd_getvalue(leaf);
+    Float log10Value;
+    memcpy(&log10Value, &value, sizeof(Float));
+    return log10Value;
+}
+
+/* Lace tasks *****************************************************************/
+
+// mtbdd_false is zero; operands are swapped into a canonical order for the operation cache
+TASK_IMPL_2(MTBDD, log_op_times, MTBDD*, pa, MTBDD*, pb) {
+    MTBDD a = *pa, b = *pb;
+    if (a == sylvan::mtbdd_false || b == sylvan::mtbdd_false) return sylvan::mtbdd_false;
+    if (sylvan::mtbdd_isleaf(a) && sylvan::mtbdd_isleaf(b)) {
+        return LogLeaf::getLeaf(LogLeaf::getLog10(a) + LogLeaf::getLog10(b));
+    }
+    if (a > b) {
+        *pa = b;
+        *pb = a;
+    }
+    return sylvan::mtbdd_invalid;
+}
+
+TASK_IMPL_2(MTBDD, log_op_plus, MTBDD*, pa, MTBDD*, pb) {
+    MTBDD a = *pa, b = *pb;
+    if (a == sylvan::mtbdd_false) return b;
+    if (b == sylvan::mtbdd_false) return a;
+    if (sylvan::mtbdd_isleaf(a) && sylvan::mtbdd_isleaf(b)) {
+        return LogLeaf::getLeaf(Number(LogLeaf::getLog10(a)).getLogSumExp(Number(LogLeaf::getLog10(b))));
+    }
+    if (a > b) {
+        *pa = b;
+        *pb = a;
+    }
+    return sylvan::mtbdd_invalid;
+}
+
+// log10 is increasing, so the max of logs is the log of the max
+TASK_IMPL_2(MTBDD, log_op_max, MTBDD*, pa, MTBDD*, pb) {
+    MTBDD a = *pa, b = *pb;
+    if (a == sylvan::mtbdd_false) return b;
+    if (b == sylvan::mtbdd_false) return a;
+    if (sylvan::mtbdd_isleaf(a) && sylvan::mtbdd_isleaf(b)) {
+        return LogLeaf::getLog10(a) >= LogLeaf::getLog10(b) ? a : b;
+    }
+    if (a > b) {
+        *pa = b;
+        *pb = a;
+    }
+    return sylvan::mtbdd_invalid;
+}
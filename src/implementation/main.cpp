@@ -19,6 +19,19 @@ void OptionDict::printOptionalOptions() const {
     util::printMultiplePrecisionOption();
     util::printMaximumMemoryOption();
     util::printPreprocessorOption();
+    util::printBackboneWorkerOption();
+    util::printBackboneTimeOption();
+    util::printPreprocessPassOption();
+    util::printVivifyLiteralOption();
+    util::printThreadCountOption();
+    util::printComponentWorkerOption();
+    util::printModularCountingOption();
+    util::printLogCountingOption();
+    util::printTieredLeafOption();
+    util::printProductSchedulingOption();
+    util::printCacheFileOption();
+    util::printCompileFileOption();
+    util::printEvaluateFileOption();
 }
 
 void OptionDict::printHelp() const {
@@ -58,7 +71,20 @@ OptionDict::OptionDict(int argc, char* argv[]) {
                         (DIAGRAM_PACKAGE_OPTION, "", cxxopts::value<string>()->default_value(DEFAULT_DIAGRAM_PACKAGE))
                         (MULTIPLE_PRECISION_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_MULTIPLE_PRECISION)))
                         (MAXIMUM_MEMORY_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_MAXIMUM_MEMORY)))
-                        (PREPROCESSOR_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_PREPROCESSOR)));
+                        (PREPROCESSOR_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_PREPROCESSOR)))
+                        (BACKBONE_WORKER_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_BACKBONE_WORKER_COUNT)))
+                        (BACKBONE_TIME_OPTION, "", cxxopts::value<string>()->default_value(to_string(Int(DEFAULT_BACKBONE_TIME_LIMIT))))
+                        (PREPROCESS_PASS_OPTION, "", cxxopts::value<string>()->default_value(DEFAULT_PREPROCESS_PASSES))
+                        (VIVIFY_LITERAL_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_VIVIFY_LITERAL_LIMIT)))
+                        (THREAD_COUNT_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_THREAD_COUNT)))
+                        (COMPONENT_WORKER_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_COMPONENT_WORKER_COUNT)))
+                        (MODULAR_COUNTING_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_MODULAR_COUNTING)))
+                        (LOG_COUNTING_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_LOG_COUNTING)))
+                        (TIERED_LEAF_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_TIERED_LEAVES)))
+                        (PRODUCT_SCHEDULING_OPTION, "", cxxopts::value<string>()->default_value(to_string(DEFAULT_PRODUCT_SCHEDULING_CHOICE)))
+                        (CACHE_FILE_OPTION, "", cxxopts::value<string>()->default_value(""))
+                        (COMPILE_FILE_OPTION, "", cxxopts::value<string>()->default_value(""))
+                        (EVALUATE_FILE_OPTION, "", cxxopts::value<string>()->default_value(""));
 
     cxxopts::ParseResult result = options->parse(argc, argv);
 
@@ -78,6 +104,19 @@ OptionDict::OptionDict(int argc, char* argv[]) {
     multiplePrecisionOption = std::stoll(result[MULTIPLE_PRECISION_OPTION].as<string>());
     maximumMemoryOtion = std::stoll(result[MAXIMUM_MEMORY_OPTION].as<string>());
     preprocessorOption = std::stoll(result[PREPROCESSOR_OPTION].as<string>());
+    backboneWorkerOption = std::stoll(result[BACKBONE_WORKER_OPTION].as<string>());
+    backboneTimeOption = std::stold(result[BACKBONE_TIME_OPTION].as<string>());
+    preprocessPassOption = result[PREPROCESS_PASS_OPTION].as<string>();
+    vivifyLiteralOption = std::stoll(result[VIVIFY_LITERAL_OPTION].as<string>());
+    threadCountOption = std::stoll(result[THREAD_COUNT_OPTION].as<string>());
+    componentWorkerOption = std::stoll(result[COMPONENT_WORKER_OPTION].as<string>());
+    modularCountingOption = std::stoll(result[MODULAR_COUNTING_OPTION].as<string>());
+    logCountingOption = std::stoll(result[LOG_COUNTING_OPTION].as<string>());
+    tieredLeafOption = std::stoll(result[TIERED_LEAF_OPTION].as<string>());
+    productSchedulingOption = std::stoll(result[PRODUCT_SCHEDULING_OPTION].as<string>());
+    cacheFileOption = result[CACHE_FILE_OPTION].as<string>();
+    compileFileOption = result[COMPILE_FILE_OPTION].as<string>();
+    evaluateFileOption = result[EVALUATE_FILE_OPTION].as<string>();
 }
 
 /* namespaces *****************************************************************/
@@ -155,16 +194,81 @@ void solving::solveFile(
         util::printRow("randomSeed", randomSeed);
         util::printRow("diagramPackage", ddPackage);
         util::printRow("multiplePrecision", multiplePrecision);
+        util::printRow("threadCount", threadCount);
+        util::printRow("componentWorkers", componentWorkerCount);
+        util::printRow("modularCounting", modularCounting);
+        util::printRow("logCounting", logCounting);
+        util::printRow("tieredLeaves", tieredLeaves);
+        if (preprocessorFlag) {
+            util::printRow("backboneWorkers", backboneWorkerCount);
+            util::printRow("backboneTimeLimit", backboneTimeLimit);
+            util::printRow("preprocessPasses", preprocessPasses);
+            util::printRow("vivifyLiteralLimit", vivifyLiteralLimit);
+        }
+        util::printRow("productScheduling", util::getProductSchedulingName(productScheduling));
+        if (!cacheFilePath.empty()) util::printRow("cacheFile", cacheFilePath);
+        if (!compileFilePath.empty()) util::printRow("compileFile", compileFilePath);
+        if (!evaluateFilePath.empty()) util::printRow("evaluateFile", evaluateFilePath);
+    }
+
+    if (backboneWorkerCount < 1) {
+        showError("no such backboneWorkerCount: " + to_string(backboneWorkerCount));
+    }
+
+    if (preprocessorFlag) Preprocessor::getPasses(preprocessPasses);  // rejects unknown passes before parsing
+
+    if (threadCount < 0) {
+        showError("no such threadCount: " + to_string(threadCount));
+    } else if (threadCount != 1 && ddPackage == CUDD_PACKAGE) {
+        showWarning("CUDD Package is single-threaded; ignoring threadCount " + to_string(threadCount));
+    }
+
+    if (componentWorkerCount < 1) {
+        showError("no such componentWorkerCount: " + to_string(componentWorkerCount));
+    } else if (componentWorkerCount != 1 && ddPackage == SYLVAN_PACKAGE) {
+        showWarning("Sylvan components are counted one after another with all Lace workers; ignoring componentWorkerCount " + to_string(componentWorkerCount));
+    }
+
+    if (modularCounting && (ddPackage != SYLVAN_PACKAGE || !multiplePrecision)) {
+        showError("modular counting needs the Sylvan Package with multiplePrecision");
+    }
+
+    if (logCounting && multiplePrecision) {
+        showError("log counting uses double leaves, so it needs multiplePrecision 0");
+    }
+
+    if (!compileFilePath.empty() && !evaluateFilePath.empty()) {
+        showError("a run either compiles a diagram or evaluates one, not both");
+    }
+
+    if ((!compileFilePath.empty() || !evaluateFilePath.empty()) && logCounting) {
+        showError("compiled diagrams are evaluated with linear weights, so they need logCounting 0");
+    }
+
+    if (!evaluateFilePath.empty()) {  // needs no diagram package
+        CompiledDiagram::evaluateFile(evaluateFilePath, cnfFilePath, weightFormat);
+        return;
     }
 
     if (ddPackage == SYLVAN_PACKAGE) {  // initializes Sylvan
-        lace_init(1ll, 0);
-        lace_startup(0, NULL, NULL);
+        lace_init(threadCount, 0);          // Dd operations are Lace tasks, so every apply is parallel with > 1 worker
+        lace_startup(0, NULL, NULL);        // main thread becomes worker 0
+        if (verbosityLevel >= 1) util::printRow("laceWorkers", lace_workers());
         sylvan::sylvan_set_limits(maxMem * MEGA, tableRatio, initRatio);
         sylvan::sylvan_init_package();
         sylvan::sylvan_init_mtbdd();
         if (multiplePrecision) {
             sylvan::gmp_init();
+            if (tieredLeaves) TieredLeaf::initLeafType();  // takes over from gmp leaves
+        }
+        if (modularCounting) {
+            ModularField::initLeafType();
+        }
+        if (logCounting) {
+            LogLeaf::initLeafType();
+        }
+        if (!multiplePrecision && !logCounting) {
+            LaneLeaf::initLeafType();  // used only if the input gives several weight vectors
         }
     }
 
@@ -267,6 +371,23 @@ void solving::solveCommand(int argc, char* argv[]) {
     multiplePrecision = optionDict.multiplePrecisionOption;     // global variable
     ddPackage = optionDict.diagramPackageOption;                // golbal variable
     preprocessorFlag = optionDict.preprocessorOption;           // golbal variable
+    backboneWorkerCount = optionDict.backboneWorkerOption;      // global variable
+    backboneTimeLimit = optionDict.backboneTimeOption;          // global variable
+    preprocessPasses = optionDict.preprocessPassOption;         // global variable
+    vivifyLiteralLimit = optionDict.vivifyLiteralOption;        // global variable
+    threadCount = optionDict.threadCountOption;                 // global variable
+    componentWorkerCount = optionDict.componentWorkerOption;    // global variable
+    modularCounting = optionDict.modularCountingOption;         // global variable
+    logCounting = optionDict.logCountingOption;                 // global variable
+    tieredLeaves = optionDict.tieredLeafOption;                 // global variable
+    cacheFilePath = optionDict.cacheFileOption;                 // global variable
+    compileFilePath = optionDict.compileFileOption;             // global variable
+    evaluateFilePath = optionDict.evaluateFileOption;           // global variable
+    try {
+        productScheduling = PRODUCT_SCHEDULING_CHOICES.at(optionDict.productSchedulingOption);  // global variable
+    } catch (const std::out_of_range&) {
+        showError("no such productSchedulingOption: " + to_string(optionDict.productSchedulingOption));
+    }
 
     if (optionDict.helpFlag) {
         optionDict.printHelp();
@@ -0,0 +1,266 @@
+/* inclusions *****************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+
+#include "../interface/modular.hpp"
+
+/* uses ***********************************************************************/
+
+using sylvan::MTBDD;
+using util::showError;
+
+/* helpers ********************************************************************/
+
+using Uint128 = __uint128_t;
+
+static uint64_t powMod(uint64_t base, uint64_t exponent, uint64_t modulus) {
+    uint64_t result = 1;
+    base %= modulus;
+    while (exponent > 0) {
+        if (exponent & 1) result = Uint128(result) * base % modulus;
+        base = Uint128(base) * base % modulus;
+        exponent >>= 1;
+    }
+    return result;
+}
+
+// Miller-Rabin with the first twelve prime bases is exact below 2^64
+static bool isPrime(uint64_t n) {
+    if (n < 2) return false;
+    const uint64_t bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    for (uint64_t p : bases) {
+        if (n % p == 0) return n == p;
+    }
+    uint64_t d = n - 1;
+    Int s = 0;
+    while ((d & 1) == 0) {
+        d >>= 1;
+        s++;
+    }
+    for (uint64_t a : bases) {
+        uint64_t x = powMod(a, d, n);
+        if (x == 1 || x == n - 1) continue;
+        bool composite = true;
+        for (Int i = 1; i < s && composite; i++) {
+            x = Uint128(x) * x % n;
+            composite = x != n - 1;
+        }
+        if (composite) return false;
+    }
+    return true;
+}
+
+static Int getWordCount(uint64_t value) {
+    return reinterpret_cast<const uint64_t*>(value)[0] + 1;
+}
+
+/* Sylvan leaf callbacks ******************************************************/
+
+static uint64_t hashLeaf(uint64_t value, uint64_t seed) {
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(value);
+    uint64_t hash = seed ^ 14695981039346656037ULL;
+    for (Int i = 0; i < getWordCount(value); i++) {
+        hash = (hash ^ words[i]) * 1099511628211ULL;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+static int equalLeaves(uint64_t left, uint64_t right) {
+    Int wordCount = getWordCount(left);
+    return wordCount == getWordCount(right) &&
+           memcmp(reinterpret_cast<const void*>(left), reinterpret_cast<const void*>(right), wordCount * sizeof(uint64_t)) == 0;
+}
+
+// Sylvan passes the caller's temporary array, to be replaced by a copy the leaf owns
+static void createLeaf(uint64_t* value) {
+    size_t size = getWordCount(*value) * sizeof(uint64_t);
+    void* copy = malloc(size);
+    memcpy(copy, reinterpret_cast<const void*>(*value), size);
+    *value = reinterpret_cast<uint64_t>(copy);
+}
+
+static void destroyLeaf(uint64_t value) {
+    free(reinterpret_cast<void*>(value));
+}
+
+static char* leafToString(int complemented, uint64_t value, char* buf, size_t bufsize) {
+    string s = "modular";
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(value);
+    if (Int(words[0]) == ModularField::primeCount) {  // else left by an earlier init
+        s = ModularField::getNumber(words).quotient.get_str();
+    }
+    if (s.size() < bufsize) {
+        memcpy(buf, s.c_str(), s.size() + 1);
+        return buf;
+    }
+    return strdup(s.c_str());
+}
+
+/* class ModularField *********************************************************/
+
+uint32_t ModularField::leafType;
+vector<uint64_t> ModularField::primes;
+vector<uint64_t> ModularField::negativeInverses;
+vector<uint64_t> ModularField::montgomerySquares;
+mpz_class ModularField::denominator;
+mpz_class ModularField::modulus;
+Int ModularField::primeCount = 0;
+
+void ModularField::initLeafType() {
+    leafType = sylvan::sylvan_mt_create_type();
+    sylvan::sylvan_mt_set_hash(leafType, hashLeaf);
+    sylvan::sylvan_mt_set_equals(leafType, equalLeaves);
+    sylvan::sylvan_mt_set_create(leafType, createLeaf);
+    sylvan::sylvan_mt_set_destroy(leafType, destroyLeaf);
+    sylvan::sylvan_mt_set_to_str(leafType, leafToString);
+}
+
+// |count * denominator| <= product over vars of (|w(var)| + |w(-var)|) * lcm of their denominators
+void ModularField::init(const Map<Int, Number>& literalWeights) {
+    denominator = 1;
+    mpz_class bound = 1;
+    for (const auto& kv : literalWeights) {
+        if (kv.first < 0) continue;
+        const mpq_class& positiveWeight = kv.second.quotient;
+        const mpq_class& negativeWeight = literalWeights.at(-kv.first).quotient;
+        mpz_class varDenominator;
+        mpz_lcm(varDenominator.get_mpz_t(), positiveWeight.get_den_mpz_t(), negativeWeight.get_den_mpz_t());
+        mpq_class weightSum = abs(positiveWeight) + abs(negativeWeight);
+        mpz_class scaledSum = weightSum.get_num() * (varDenominator / weightSum.get_den());
+        denominator *= varDenominator;
+        bound *= std::max(scaledSum, varDenominator);
+    }
+
+    // a symmetric range needs modulus > 2 * bound, and every prime exceeds 2^61
+    primeCount = (mpz_sizeinbase(bound.get_mpz_t(), 2) + 1) / 61 + 1;
+    uint64_t candidate = primes.empty() ? (uint64_t(1) << 62) - 1 : primes.back() - 2;
+    while (primes.size() < primeCount) {
+        if (isPrime(candidate)) {
+            uint64_t p = candidate;
+            uint64_t inverse = p;  // correct mod 2^3 for odd p, and each Newton step doubles the correct bits
+            for (Int i = 0; i < 5; i++) inverse *= 2 - p * inverse;
+            uint64_t r = (Uint128(1) << 64) % p;
+            primes.push_back(p);
+            negativeInverses.push_back(-inverse);
+            montgomerySquares.push_back(Uint128(r) * r % p);
+        }
+        candidate -= 2;
+    }
+    modulus = 1;
+    for (Int i = 0; i < primeCount; i++) modulus *= primes[i];
+}
+
+uint64_t ModularField::multiply(uint64_t a, uint64_t b, Int primeIndex) {
+    uint64_t p = primes[primeIndex];
+    Uint128 t = Uint128(a) * b;
+    uint64_t m = uint64_t(t) * negativeInverses[primeIndex];
+    uint64_t result = (t + Uint128(m) * p) >> 64;
+    return result >= p ? result - p : result;
+}
+
+uint64_t ModularField::add(uint64_t a, uint64_t b, Int primeIndex) {
+    uint64_t p = primes[primeIndex];
+    uint64_t result = a + b;  // < 2^63
+    return result >= p ? result - p : result;
+}
+
+// CRT as the sum of residue_i * (modulus / p_i) * ((modulus / p_i)^-1 mod p_i)
+// the residues are of value * denominator, an integer whenever value is a count over the weights of init
+mpz_class ModularField::getInteger(const uint64_t* residues) {
+    mpz_class x = 0;
+    for (Int i = 0; i < primeCount; i++) {
+        uint64_t denominatorResidue = mpz_fdiv_ui(denominator.get_mpz_t(), primes[i]);
+        uint64_t residue = Uint128(multiply(residues[i], 1, i)) * denominatorResidue % primes[i];  // out of Montgomery form
+        if (residue == 0) continue;
+        mpz_class cofactor = modulus / primes[i];
+        mpz_class inverse = mpz_fdiv_ui(cofactor.get_mpz_t(), primes[i]);
+        mpz_invert(inverse.get_mpz_t(), inverse.get_mpz_t(), mpz_class(primes[i]).get_mpz_t());
+        x += cofactor * ((mpz_class(residue) * inverse) % primes[i]);
+    }
+    x %= modulus;
+    if (2 * x > modulus) x -= modulus;
+    return x;
+}
+
+MTBDD ModularField::getLeaf(const Number& n) {
+    if (n == Number()) return sylvan::mtbdd_false;
+
+    vector<uint64_t> words(primeCount + 1);
+    words[0] = primeCount;
+    for (Int i = 0; i < primeCount; i++) {
+        uint64_t denominatorResidue = mpz_fdiv_ui(n.quotient.get_den_mpz_t(), primes[i]);
+        if (denominatorResidue == 0) showError("weight denominator is divisible by modular prime " + to_string(primes[i]));
+        uint64_t inverse = powMod(denominatorResidue, primes[i] - 2, primes[i]);  // Fermat
+        uint64_t residue = Uint128(mpz_fdiv_ui(n.quotient.get_num_mpz_t(), primes[i])) * inverse % primes[i];
+        words[i + 1] = multiply(residue, montgomerySquares[i], i);
+    }
+    return sylvan::mtbdd_makeleaf(leafType, reinterpret_cast<uint64_t>(words.data()));
+}
+
+Number ModularField::getNumber(const uint64_t* words) {
+    mpq_class q(getInteger(words + 1), denominator);
+    q.canonicalize();
+    return Number(q);
+}
+
+Number ModularField::extractNumber(MTBDD leaf) {
+    if (leaf == sylvan::mtbdd_false) return Number();
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(sylvan::mtbdd_getvalue(leaf));
+    if (Int(words[0]) != primeCount) showError("modular leaf has " + to_string(words[0]) + " residues, not " + to_string(primeCount));
+    return getNumber(words);
+}
+
+/* Lace tasks *****************************************************************/
+
+// one buffer per Lace worker, so a leaf operation allocates nothing; mtbdd_makeleaf copies it through createLeaf
+static uint64_t* getResultWords() {
+    thread_local vector<uint64_t> words;
+    words.resize(ModularField::primeCount + 1);
+    words[0] = ModularField::primeCount;
+    return words.data();
+}
+
+// mtbdd_false is the zero of the field; operands are swapped into a canonical order for the operation cache
+TASK_IMPL_2(MTBDD, modular_op_times, MTBDD*, pa, MTBDD*, pb) {
+    MTBDD a = *pa, b = *pb;
+    if (a == sylvan::mtbdd_false || b == sylvan::mtbdd_false) return sylvan::mtbdd_false;
+    if (sylvan::mtbdd_isleaf(a) && sylvan::mtbdd_isleaf(b)) {
+        const uint64_t* left = reinterpret_cast<const uint64_t*>(sylvan::mtbdd_getvalue(a));
+        const uint64_t* right = reinterpret_cast<const uint64_t*>(sylvan::mtbdd_getvalue(b));
+        uint64_t* words = getResultWords();
+        for (Int i = 0; i < ModularField::primeCount; i++) {
+            words[i + 1] = ModularField::multiply(left[i + 1], right[i + 1], i);
+        }
+        return sylvan::mtbdd_makeleaf(sylvan::mtbdd_gettype(a), reinterpret_cast<uint64_t>(words));
+    }
+    if (a > b) {
+        *pa = b;
+        *pb = a;
+    }
+    return sylvan::mtbdd_invalid;
+}
+
+TASK_IMPL_2(MTBDD, modular_op_plus, MTBDD*, pa, MTBDD*, pb) {
+    MTBDD a = *pa, b = *pb;
+    if (a == sylvan::mtbdd_false) return b;
+    if (b == sylvan::mtbdd_false) return a;
+    if (sylvan::mtbdd_isleaf(a) && sylvan::mtbdd_isleaf(b)) {
+        const uint64_t* left = reinterpret_cast<const uint64_t*>(sylvan::mtbdd_getvalue(a));
+        const uint64_t* right = reinterpret_cast<const uint64_t*>(sylvan::mtbdd_getvalue(b));
+        uint64_t* words = getResultWords();
+        bool zero = true;
+        for (Int i = 0; i < ModularField::primeCount; i++) {
+            words[i + 1] = ModularField::add(left[i + 1], right[i + 1], i);
+            zero &= words[i + 1] == 0;
+        }
+        if (zero) return sylvan::mtbdd_false;
+        return sylvan::mtbdd_makeleaf(sylvan::mtbdd_gettype(a), reinterpret_cast<uint64_t>(words));
+    }
+    if (a > b) {
+        *pa = b;
+        *pb = a;
+    }
+    return sylvan::mtbdd_invalid;
+}
@@ -0,0 +1,84 @@
+/* inclusions *****************************************************************/
+
+#include "../interface/pbDd.hpp"
+
+/* class PbDdBuilder **********************************************************/
+
+PbDdBuilder::PbDdBuilder(const vector<Pair<Int, Pair<Int, Int> > >& terms, const Cudd& mgr) : mgr(mgr), terms(terms) {
+    std::sort(this->terms.begin(), this->terms.end());  // nodes are made bottom-up, so deeper levels need larger ddVars
+
+    Int termCount = this->terms.size();
+    suffixCoefSums.assign(termCount + 1, 0);
+    for (Int i = termCount - 1; i >= 0; i--) {
+        suffixCoefSums[i] = suffixCoefSums[i + 1] + this->terms[i].second.second;
+    }
+}
+
+PbDdBuilder::Interval PbDdBuilder::constructLeq(Int index, Int limit) {
+    std::map<Int, Interval>& intervals = levelIntervals[index];
+    auto it = intervals.upper_bound(limit);
+    if (it != intervals.begin() && limit <= std::prev(it)->second.rt) {
+        return std::prev(it)->second;
+    }
+
+    Int literal = terms[index].second.first;
+    Int varCoef = terms[index].second.second;
+    Int ddVar = terms[index].first;
+
+    Interval f = constructLeq(index + 1, limit);
+    Interval t = constructLeq(index + 1, limit - varCoef);
+
+    Interval interval{
+        std::max(f.lf, t.lf + varCoef),
+        t.rt == DUMMY_MAX_INT ? f.rt : std::min(f.rt, t.rt + varCoef),
+        util::isPositiveLiteral(literal) ? Dd::getNode(ddVar, t.dd, f.dd, mgr) : Dd::getNode(ddVar, f.dd, t.dd, mgr)
+    };
+
+    intervals.emplace_hint(it, interval.lf, interval);  // the recursion only touched deeper levels, and interval contains limit
+    return interval;
+}
+
+Dd PbDdBuilder::constructEq(Int index, Int limit) {
+    if (limit < 0 || limit > suffixCoefSums[index]) {  // UNSAT
+        return Dd::getZeroDd(mgr);
+    }
+
+    std::map<Int, Dd>& values = levelValues[index];
+    auto it = values.lower_bound(limit);
+    if (it != values.end() && it->first == limit) {
+        return it->second;
+    }
+
+    Int literal = terms[index].second.first;
+    Int varCoef = terms[index].second.second;
+    Int ddVar = terms[index].first;
+
+    Dd f = constructEq(index + 1, limit);
+    Dd t = constructEq(index + 1, limit - varCoef);
+    Dd dd = util::isPositiveLiteral(literal) ? Dd::getNode(ddVar, t, f, mgr) : Dd::getNode(ddVar, f, t, mgr);
+
+    values.emplace_hint(it, limit, dd);  // the recursion only touched deeper levels
+    return dd;
+}
+
+Dd PbDdBuilder::getLeqDd(Int limit) {
+    Dd zero = Dd::getZeroDd(mgr);
+    Dd one = Dd::getOneDd(mgr);
+
+    levelIntervals.assign(terms.size() + 1, std::map<Int, Interval>());
+    for (Int i = 0; i <= terms.size(); i++) {
+        levelIntervals[i].emplace(DUMMY_MIN_INT, Interval{DUMMY_MIN_INT, -1, zero});
+        levelIntervals[i].emplace(suffixCoefSums[i], Interval{suffixCoefSums[i], DUMMY_MAX_INT, one});
+    }
+    return constructLeq(0, limit).dd;
+}
+
+Dd PbDdBuilder::getEqDd(Int limit) {
+    levelValues.assign(terms.size() + 1, std::map<Int, Dd>());
+    levelValues[terms.size()].emplace(0, Dd::getOneDd(mgr));  // 0 = 0 is always true
+    return constructEq(0, limit);
+}
+
+Dd PbDdBuilder::getDd(PbRelation relation, Int limit) {
+    return relation == PbRelation::EQUAL ? getEqDd(limit) : getLeqDd(limit);
+}
@@ -0,0 +1,125 @@
+/* inclusions *****************************************************************/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <cstring>
+
+#include "../interface/pbReader.hpp"
+
+/* classes ********************************************************************/
+
+/* class InputBuffer **********************************************************/
+
+void InputBuffer::readStream(std::istream& inputStream) {
+    const Int chunkSize = 1 << 16;
+    char chunk[chunkSize];
+    while (inputStream.read(chunk, chunkSize) || inputStream.gcount() > 0) {
+        ownedData.append(chunk, inputStream.gcount());
+    }
+    data = ownedData.data();
+    size = ownedData.size();
+}
+
+InputBuffer::InputBuffer(const string& filePath) {
+    if (filePath == STDIN_CONVENTION) {
+        readStream(std::cin);
+        return;
+    }
+
+    int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        util::showError("unable to open file '" + filePath + "'");
+    }
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) == 0 && S_ISREG(fileStatus.st_mode) && fileStatus.st_size > 0) {
+        void* mapping = mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (mapping != MAP_FAILED) {
+            madvise(mapping, fileStatus.st_size, MADV_SEQUENTIAL);
+            mappedData = mapping;
+            data = static_cast<const char*>(mapping);
+            size = fileStatus.st_size;
+        }
+    }
+    close(fileDescriptor);
+
+    if (mappedData == nullptr) {  // pipes, empty files, failed mappings
+        std::ifstream inputFileStream(filePath, std::ios::binary);
+        readStream(inputFileStream);
+    }
+}
+
+InputBuffer::~InputBuffer() {
+    if (mappedData != nullptr) {
+        munmap(mappedData, size);
+    }
+}
+
+const char* InputBuffer::begin() const {
+    return data;
+}
+
+const char* InputBuffer::end() const {
+    return data + size;
+}
+
+Int InputBuffer::getSize() const {
+    return size;
+}
+
+bool InputBuffer::isMapped() const {
+    return mappedData != nullptr;
+}
+
+/* class LineTokenizer ********************************************************/
+
+LineTokenizer::LineTokenizer(const InputBuffer& inputBuffer) : cursor(inputBuffer.begin()), end(inputBuffer.end()) {}
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+bool LineTokenizer::nextLine(std::string_view& line, vector<std::string_view>& words) {
+    if (cursor == end) return false;
+
+    const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', end - cursor));
+    if (lineEnd == nullptr) lineEnd = end;
+    line = std::string_view(cursor, lineEnd - cursor);
+
+    words.clear();
+    const char* c = cursor;
+    while (c != lineEnd) {
+        while (c != lineEnd && isBlank(*c)) c++;
+        const char* wordBegin = c;
+        while (c != lineEnd && !isBlank(*c)) c++;
+        if (c != wordBegin) words.emplace_back(wordBegin, c - wordBegin);
+    }
+
+    cursor = lineEnd == end ? end : lineEnd + 1;
+    return true;
+}
+
+/* namespaces *****************************************************************/
+
+Int util::parseInt(std::string_view word, Int lineIndex) {
+    auto c = word.begin();
+    bool negative = false;
+    if (c != word.end() && (*c == '+' || *c == '-')) {
+        negative = *c == '-';
+        c++;
+    }
+    if (c == word.end() || *c < '0' || *c > '9') {
+        showError("expected integer, found '" + string(word) + "' -- line " + to_string(lineIndex));
+    }
+
+    Int value = 0;  // accumulated with its sign, so the most negative Int parses too
+    for (; c != word.end() && *c >= '0' && *c <= '9'; c++) {
+        Int digit = *c - '0';
+        if (__builtin_mul_overflow(value, 10, &value) ||
+            (negative ? __builtin_sub_overflow(value, digit, &value) : __builtin_add_overflow(value, digit, &value))) {
+            showError("integer '" + string(word) + "' is out of range -- line " + to_string(lineIndex));
+        }
+    }
+    return value;
+}
@@ -2,11 +2,18 @@
 
 /* inclusions *****************************************************************/
 
+#include <sys/stat.h>
+
+#include <cstring>
+#include <limits>
+
 #include "../interface/pbformula.hpp"
 
 /* constants ******************************************************************/
 
 const string &WEIGHT_WORD = "w";
+const string &CACHE_MAGIC = "PBCCACHE";
+const Int CACHE_VERSION = 2;
 
 /* classes ********************************************************************/
 
@@ -17,6 +24,97 @@ void PbLabel::addNumber(Int i) {
     std::sort(begin(), end(), std::greater<Int>());
 }
 
+/* class PbConstraintStore ****************************************************/
+
+Int PbConstraintStore::size() const {
+    return relations.size();
+}
+
+bool PbConstraintStore::empty() const {
+    return relations.empty();
+}
+
+void PbConstraintStore::add(Span<Int> clause, Span<Int> coefficient, PbRelation relation, Int limit) {
+    literals.insert(literals.end(), clause.begin(), clause.end());
+    coefficients.insert(coefficients.end(), coefficient.begin(), coefficient.end());
+    offsets.push_back(literals.size());
+    relations.push_back(relation);
+    limits.push_back(limit);
+}
+
+void PbConstraintStore::assign(vector<Int> offsets, vector<Int> literals, vector<Int> coefficients, vector<PbRelation> relations, vector<Int> limits) {
+    this->offsets = std::move(offsets);
+    this->literals = std::move(literals);
+    this->coefficients = std::move(coefficients);
+    this->relations = std::move(relations);
+    this->limits = std::move(limits);
+}
+
+void PbConstraintStore::clear() {
+    offsets.assign(1, 0);
+    literals.clear();
+    coefficients.clear();
+    relations.clear();
+    limits.clear();
+}
+
+Span<Int> PbConstraintStore::getLiterals(Int i) const {
+    return Span<Int>(literals.data() + offsets[i], literals.data() + offsets[i + 1]);
+}
+
+Span<Int> PbConstraintStore::getCoefficients(Int i) const {
+    return Span<Int>(coefficients.data() + offsets[i], coefficients.data() + offsets[i + 1]);
+}
+
+PbRelation PbConstraintStore::getRelation(Int i) const {
+    return relations[i];
+}
+
+Int PbConstraintStore::getLimit(Int i) const {
+    return limits[i];
+}
+
+const vector<Int>& PbConstraintStore::getOffsetArray() const {
+    return offsets;
+}
+
+const vector<Int>& PbConstraintStore::getLiteralArray() const {
+    return literals;
+}
+
+const vector<Int>& PbConstraintStore::getCoefficientArray() const {
+    return coefficients;
+}
+
+const vector<PbRelation>& PbConstraintStore::getRelationArray() const {
+    return relations;
+}
+
+const vector<Int>& PbConstraintStore::getLimitArray() const {
+    return limits;
+}
+
+Set<Int> PbConstraintStore::getVars(const vector<Int>& constraintIndices) const {
+    Set<Int> vars;
+    for (Int i : constraintIndices)
+        for (Int literal : getLiterals(i))
+            vars.insert(util::getPbfVar(literal));
+    return vars;
+}
+
+void PbConstraintStore::print() const {
+    printThinLine();
+    printComment("pbf {");
+    for (Int i = 0; i < size(); i++) {
+        cout << COMMENT_WORD << "\t"
+                                "Constraint ";
+        cout << std::right << std::setw(5) << i + 1 << " : ";
+        util::printConstraint(getLiterals(i), getCoefficients(i), getRelation(i), getLimit(i));
+    }
+    printComment("}");
+    printThinLine();
+}
+
 /* class Pbf ******************************************************************/
 
 void Pbf::updateApparentVars(Int literal) {
@@ -26,11 +124,8 @@ void Pbf::updateApparentVars(Int literal) {
         apparentVars.push_back(var);
 }
 
-void Pbf::addConstraint(const vector<Int>& clause, const vector<Int>& coefficient, const string& option, const Int& limit) {
-    clauses.push_back(clause);
-    coefficients.push_back(coefficient);
-    options.push_back(option);
-    limits.push_back(limit);
+void Pbf::addConstraint(Span<Int> clause, Span<Int> coefficient, PbRelation relation, Int limit) {
+    constraints.add(clause, coefficient, relation, limit);
 
     for (Int literal : clause) {
         updateApparentVars(literal);
@@ -38,20 +133,14 @@ void Pbf::addConstraint(const vector<Int>& clause, const vector<Int>& coefficien
 }
 
 Graph Pbf::getGaifmanGraph() const {
-    Set<Int> vars;
-    for (Int var : apparentVars)
-        vars.insert(var);
-    Graph graph(vars);
-
-    for (const vector<Int>& clause : clauses)
-        for (auto literal1 = clause.begin(); literal1 != clause.end(); literal1++)
-            for (auto literal2 = std::next(literal1); literal2 != clause.end(); literal2++) {
-                Int var1 = util::getPbfVar(*literal1);
-                Int var2 = util::getPbfVar(*literal2);
-                graph.addEdge(var1, var2);
-            }
-
-    return graph;
+    vector<vector<Int>> cliques;  // the vars of each constraint
+    cliques.reserve(constraints.size());
+    for (Int i = 0; i < constraints.size(); i++) {
+        cliques.emplace_back();
+        for (Int literal : constraints.getLiterals(i))
+            cliques.back().push_back(util::getPbfVar(literal));
+    }
+    return Graph(apparentVars, cliques);
 }
 
 vector<Int> Pbf::getAppearanceVarOrdering() const {
@@ -75,111 +164,32 @@ vector<Int> Pbf::getRandomVarOrdering() const {
     return varOrdering;
 }
 
-/* same as Cnf class */
 vector<Int> Pbf::getLexpVarOrdering() const {
-    Map<Int, PbLabel> unnumberedVertices;
-    for (Int vertex : apparentVars)
-        unnumberedVertices[vertex] = PbLabel();
-    vector<Int> numberedVertices;  // whose \alpha numbers are decreasing
-    Graph graph = getGaifmanGraph();
-    for (Int number = apparentVars.size(); number > 0; number--) {
-        auto vertexIt = std::max_element(unnumberedVertices.begin(),
-                                         unnumberedVertices.end(), util::isLessValued<Int, PbLabel>);
-        Int vertex = vertexIt->first;  // ignores label
-        numberedVertices.push_back(vertex);
-        unnumberedVertices.erase(vertex);
-        for (auto neighborIt = graph.beginNeighbors(vertex);
-             neighborIt != graph.endNeighbors(vertex); neighborIt++) {
-            Int neighbor = *neighborIt;
-            auto unnumberedNeighborIt = unnumberedVertices.find(neighbor);
-            if (unnumberedNeighborIt != unnumberedVertices.end()) {
-                Int unnumberedNeighbor = unnumberedNeighborIt->first;
-                unnumberedVertices.at(unnumberedNeighbor).addNumber(number);
-            }
-        }
-    }
-    return numberedVertices;
+    return getGaifmanGraph().getLexpOrdering();
 }
 
 vector<Int> Pbf::getLexmVarOrdering() const {
-    Map<Int, PbLabel> unnumberedVertices;
-    for (Int vertex : apparentVars)
-        unnumberedVertices[vertex] = PbLabel();
-    vector<Int> numberedVertices;  // whose \alpha numbers are decreasing
-    Graph graph = getGaifmanGraph();
-    for (Int i = apparentVars.size(); i > 0; i--) {
-        auto vIt = std::max_element(unnumberedVertices.begin(),
-                                    unnumberedVertices.end(), util::isLessValued<Int, PbLabel>);
-        Int v = vIt->first;  // ignores label
-        numberedVertices.push_back(v);
-        unnumberedVertices.erase(v);
-
-        /* updates numberedVertices: */
-        Graph subgraph = getGaifmanGraph();  // will only contain v, w, and unnumbered vertices whose labels are less than w's
-        for (auto wIt = unnumberedVertices.begin(); wIt != unnumberedVertices.end(); wIt++) {
-            Int w = wIt->first;
-            PbLabel& wLabel = wIt->second;
-
-            /* removes numbered vertices except v: */
-            for (Int numberedVertex : numberedVertices)
-                if (numberedVertex != v)
-                    subgraph.removeVertex(numberedVertex);
-
-            /* removes each non-w unnumbered vertex whose label is not less than w's */
-            for (const std::pair<Int, PbLabel>& kv : unnumberedVertices) {
-                Int unnumberedVertex = kv.first;
-                const PbLabel& label = kv.second;
-                if (unnumberedVertex != w && label >= wLabel)
-                    subgraph.removeVertex(unnumberedVertex);
-            }
-
-            if (subgraph.hasPath(v, w))
-                wLabel.addNumber(i);
-        }
-    }
-    return numberedVertices;
+    return getGaifmanGraph().getLexmOrdering();
 }
 
 vector<Int> Pbf::getMcsVarOrdering() const {
-    Graph graph = getGaifmanGraph();
-
-    auto startVertex = graph.beginVertices();
-    if (startVertex == graph.endVertices())  // empty graph
-        return vector<Int>();
-
-    Map<Int, Int> rankedNeighborCounts;  // unranked vertex |-> number of ranked neighbors
-    for (auto it = std::next(startVertex); it != graph.endVertices(); it++)
-        rankedNeighborCounts[*it] = 0;
-
-    Int bestVertex = *startVertex;
-    Int bestRankedNeighborCount = DUMMY_MIN_INT;
-
-    vector<Int> varOrdering;
-    do {
-        varOrdering.push_back(bestVertex);
-
-        rankedNeighborCounts.erase(bestVertex);
-
-        for (auto n = graph.beginNeighbors(bestVertex); n != graph.endNeighbors(bestVertex); n++) {
-            auto entry = rankedNeighborCounts.find(*n);
-            if (entry != rankedNeighborCounts.end())
-                entry->second++;
-        }
-
-        bestRankedNeighborCount = DUMMY_MIN_INT;
-        for (const std::pair<Int, Int>& entry : rankedNeighborCounts)
-            if (entry.second > bestRankedNeighborCount) {
-                bestRankedNeighborCount = entry.second;
-                bestVertex = entry.first;
-            }
-    } while (bestRankedNeighborCount != DUMMY_MIN_INT);
+    return getGaifmanGraph().getMcsOrdering();
+}
 
-    return varOrdering;
+/* greedy elimination: the cheapest vertex of the remaining graph comes next */
+vector<Int> Pbf::getEliminationVarOrdering(EliminationCost eliminationCost, Int& inducedWidth) const {
+    return getGaifmanGraph().getEliminationOrdering(eliminationCost, inducedWidth);
 }
 
 /* Public functions */
 
 vector<Int> Pbf::getVarOrdering(VarOrderingHeuristic varOrderingHeuristic, bool inverse) const {
+    Int inducedWidth;
+    return getVarOrdering(varOrderingHeuristic, inverse, inducedWidth);
+}
+
+vector<Int> Pbf::getVarOrdering(VarOrderingHeuristic varOrderingHeuristic, bool inverse, Int& inducedWidth) const {
+    inducedWidth = DUMMY_MIN_INT;
     vector<Int> varOrdering;             // make varOrdering
     switch (varOrderingHeuristic) {
         case VarOrderingHeuristic::APPEARANCE: {
@@ -206,16 +216,33 @@ vector<Int> Pbf::getVarOrdering(VarOrderingHeuristic varOrderingHeuristic, bool
             varOrdering = getMcsVarOrdering();
             break;
         }
+        case VarOrderingHeuristic::MINFILL: {
+            varOrdering = getEliminationVarOrdering(EliminationCost::FILL, inducedWidth);
+            break;
+        }
+        case VarOrderingHeuristic::MINDEGREE: {
+            varOrdering = getEliminationVarOrdering(EliminationCost::DEGREE, inducedWidth);
+            break;
+        }
+        case VarOrderingHeuristic::WEIGHTED_MINFILL: {
+            varOrdering = getEliminationVarOrdering(EliminationCost::WEIGHTED_FILL, inducedWidth);
+            break;
+        }
         default: {
             showError("DUMMY_VAR_ORDERING_HEURISTIC -- Pbf::getVarOrdering");
         }
     }
     if (inverse) {
         util::invert(varOrdering);
+        inducedWidth = DUMMY_MIN_INT;  // the width was of the uninverted ordering
     }
     return varOrdering;
 }
 
+Int Pbf::getInducedWidth(const vector<Int>& varOrdering) const {
+    return getGaifmanGraph().getInducedWidth(varOrdering);
+}
+
 Int Pbf::getDeclaredVarCount() const {
     return declaredVarCount;
 }
@@ -228,112 +255,341 @@ Map<Int, Number> Pbf::getLiteralWeights() const {
     return literalWeights; 
 }
 
-Int Pbf::getEmptyClauseIndex() const {
-    for (Int clauseIndex = 0; clauseIndex < clauses.size(); clauseIndex++) {
-        if (clauses.at(clauseIndex).empty()) {
-            return clauseIndex;
-        }
-    }
-    return DUMMY_MIN_INT;
+Int Pbf::getLaneCount() const {
+    return std::max(Int(laneWeights.size()), Int(1));
 }
 
-const vector<vector<Int>>& Pbf::getClauses() const {
-    return clauses;
+const Map<Int, Number>& Pbf::getLaneWeights(Int lane) const {
+    return laneWeights.empty() ? literalWeights : laneWeights.at(lane);
 }
 
-const vector<vector<Int>>& Pbf::getCoefficients() const {
-    return coefficients;
+const vector<Map<Int, Number>>& Pbf::getLaneWeights() const {
+    return laneWeights;
 }
 
-const vector<string>& Pbf::getOptions() const {
-    return options;
+Pbf Pbf::getLane(Int lane) const {
+    Pbf pbf(*this);
+    pbf.literalWeights = getLaneWeights(lane);
+    pbf.laneWeights.clear();
+    return pbf;
 }
 
-const vector<Int>& Pbf::getLimits() const {
-    return limits;
+static void substituteWeights(Map<Int, Number>& weights, Int var, Int literal) {
+    weights[literal] *= weights.at(var);
+    weights[-literal] *= weights.at(-var);
+    weights[var] = Number("1");
+    weights[-var] = Number("0");
 }
 
-void Pbf::clearConstraints() {
-    clauses.clear();
-    coefficients.clear();
-    options.clear();
-    limits.clear();
+// literal takes over the weights of var, and var (no longer in any constraint) contributes a factor of 1
+bool Pbf::substituteVar(Int var, Int literal) {
+    for (Int lit : {var, -var, literal, -literal}) {
+        if (literalWeights.count(lit) == 0) return false;
+    }
+    substituteWeights(literalWeights, var, literal);
+    for (Map<Int, Number>& weights : laneWeights) substituteWeights(weights, var, literal);
+    substitutions.push_back({var, literal});
+    return true;
+}
+
+const vector<Pair<Int, Int>>& Pbf::getSubstitutions() const {
+    return substitutions;
+}
+
+void Pbf::removeApparentVar(Int var) {
+    apparentVars.erase(std::remove(apparentVars.begin(), apparentVars.end(), var), apparentVars.end());
+}
+
+// a component holds only the weights of its own vars, so the components count independently
+// and the model count is the product of their counts and getUnconstrainedWeight
+vector<Pbf> Pbf::getComponents() const {
+    Int varCnt = std::max(apparentVarCount, Int(0));
+    vector<Int> parents(varCnt + 1);
+    for (Int var = 0; var <= varCnt; var++) parents[var] = var;
+    auto findRoot = [&parents](Int var) {
+        while (parents[var] != var) {
+            parents[var] = parents[parents[var]];  // path halving
+            var = parents[var];
+        }
+        return var;
+    };
+    for (Int i = 0; i < constraints.size(); i++) {
+        Span<Int> literals = constraints.getLiterals(i);
+        for (Int j = 1; j < literals.size(); j++) {
+            parents[findRoot(util::getPbfVar(literals[j]))] = findRoot(util::getPbfVar(literals[0]));
+        }
+    }
+
+    vector<Pbf> components;
+    vector<Int> componentIndices(varCnt + 1, DUMMY_MIN_INT);  // root |-> index in components
+    vector<Int> componentVars(varCnt + 1, 0);                 // var |-> var in its component
+    vector<Int> literals;
+    for (Int i = 0; i < constraints.size(); i++) {
+        Span<Int> clause = constraints.getLiterals(i);
+        if (clause.empty()) continue;
+
+        Int root = findRoot(util::getPbfVar(clause[0]));
+        if (componentIndices[root] == DUMMY_MIN_INT) {
+            componentIndices[root] = components.size();
+            components.emplace_back();
+            components.back().weightFormat = weightFormat;
+            components.back().declaredVarCount = 0;
+            components.back().laneWeights.resize(laneWeights.size());
+        }
+        Pbf& component = components[componentIndices[root]];
+
+        literals.clear();
+        for (Int literal : clause) {
+            Int var = util::getPbfVar(literal);
+            if (componentVars[var] == 0) {
+                componentVars[var] = ++component.declaredVarCount;
+                for (Int lit : {var, -var}) {
+                    Int componentLit = lit > 0 ? componentVars[var] : -componentVars[var];
+                    auto it = literalWeights.find(lit);
+                    if (it != literalWeights.end()) component.literalWeights[componentLit] = it->second;
+                    for (Int lane = 0; lane < laneWeights.size(); lane++) {
+                        auto laneIt = laneWeights[lane].find(lit);
+                        if (laneIt != laneWeights[lane].end()) component.laneWeights[lane][componentLit] = laneIt->second;
+                    }
+                }
+            }
+            literals.push_back(literal > 0 ? componentVars[var] : -componentVars[var]);
+        }
+        component.addConstraint(literals, constraints.getCoefficients(i), constraints.getRelation(i), constraints.getLimit(i));
+    }
+    return components;
 }
 
-void Pbf::setClauses(vector<vector<Int> > clauses) {
-    this->clauses = clauses;
+Number Pbf::getUnconstrainedWeight(Int lane) const {
+    const Map<Int, Number>& literalWeights = getLaneWeights(lane);
+    Int totalVarCount = literalWeights.size() / 2;
+    vector<bool> constrained(std::max(totalVarCount, apparentVarCount) + 1, false);
+    for (Int literal : constraints.getLiteralArray()) constrained[util::getPbfVar(literal)] = true;
+
+    Number weight = logCounting ? Number() : Number("1");  // log10(1) if logCounting
+    for (Int var = 1; var <= totalVarCount; var++) {
+        if (constrained[var]) continue;
+        Number weightSum = literalWeights.at(var) + literalWeights.at(-var);
+        weight = logCounting ? Number(weight.fraction + weightSum.getLog10()) : weight * weightSum;  // a linear product of many small sums would underflow
+    }
+    return weight;
 }
 
-void Pbf::setCoefficients(vector<vector<Int> > coef) {
-    this->coefficients = coef;
+Int Pbf::getEmptyClauseIndex() const {
+    for (Int clauseIndex = 0; clauseIndex < constraints.size(); clauseIndex++) {
+        if (constraints.getLiterals(clauseIndex).empty()) {
+            return clauseIndex;
+        }
+    }
+    return DUMMY_MIN_INT;
 }
 
-void Pbf::setOptions(vector<string> options) {
-    this->options = options;
+const PbConstraintStore& Pbf::getConstraints() const {
+    return constraints;
 }
 
-void Pbf::setLimits(vector<Int> limits) {
-    this->limits = limits;
+void Pbf::clearConstraints() {
+    constraints.clear();
 }
 
 void Pbf::printConstraints() const {
-    util::printPbf(clauses, coefficients, options, limits);
+    constraints.print();
+}
+
+/* binary cache: CACHE_MAGIC, then native Ints
+   (header, constraint offsets, literals, coefficients, relations, limits, apparentVars, weighted literals, weight lengths),
+   then the weights as text so that they are parsed back exactly, the lanes of a batched input separated by spaces */
+
+static const Int CACHE_HEADER_SIZE = 11;
+
+PbfCacheKey Pbf::getCacheKey(const string& filePath, WeightFormat weightFormat) {
+    PbfCacheKey key;
+    struct stat fileStatus;
+    if (filePath != STDIN_CONVENTION && stat(filePath.c_str(), &fileStatus) == 0 && S_ISREG(fileStatus.st_mode)) {
+        key.sourceSize = fileStatus.st_size;
+        key.sourceModificationTime = Int(fileStatus.st_mtim.tv_sec) * 1000000000 + fileStatus.st_mtim.tv_nsec;
+    }
+    key.weightFormat = Int(weightFormat);
+    key.preprocessed = preprocessorFlag ? Int(std::hash<string>()(preprocessPasses + "/" + to_string(vivifyLiteralLimit)) | 1) : 0;
+    key.multiplePrecision = multiplePrecision;
+    return key;
+}
+
+bool Pbf::readCache(const string& cachePath, const PbfCacheKey& key) {
+    if (key.sourceSize < 0 || access(cachePath.c_str(), R_OK) != 0) return false;
+
+    InputBuffer inputBuffer(cachePath);  // mapped, so only the parts read below are paged in
+    const char* cursor = inputBuffer.begin();
+    auto readBytes = [&](Int byteCount) -> const char* {
+        if (byteCount < 0 || inputBuffer.end() - cursor < byteCount) return nullptr;
+        const char* bytes = cursor;
+        cursor += byteCount;
+        return bytes;
+    };
+    auto readInts = [&](Int count, vector<Int>& ints) {
+        const char* bytes = readBytes(count * Int(sizeof(Int)));
+        if (bytes == nullptr) return false;
+        ints.resize(count);
+        std::memcpy(ints.data(), bytes, count * sizeof(Int));
+        return true;
+    };
+
+    const char* magic = readBytes(CACHE_MAGIC.size());
+    vector<Int> header;
+    if (magic == nullptr || string(magic, CACHE_MAGIC.size()) != CACHE_MAGIC || !readInts(CACHE_HEADER_SIZE, header)) {
+        showWarning("ignoring malformed cache file '" + cachePath + "'");
+        return false;
+    }
+    if (header[0] != CACHE_VERSION || header[1] != key.sourceSize || header[2] != key.sourceModificationTime ||
+        header[3] != key.weightFormat || header[4] != key.preprocessed || header[5] != key.multiplePrecision) {
+        printComment("Cache file does not match input; rebuilding it", 1);
+        return false;
+    }
+    Int constraintCount = header[8], apparentCount = header[9], weightCount = header[10];
+
+    vector<Int> offsets, literals, coefs, relations, constraintLimits, vars, weightedLiterals, weightLengths;
+    bool complete = readInts(constraintCount + 1, offsets) && offsets.front() == 0 &&
+                    readInts(offsets.back(), literals) && readInts(offsets.back(), coefs) &&
+                    readInts(constraintCount, relations) && readInts(constraintCount, constraintLimits) &&
+                    readInts(apparentCount, vars) && readInts(weightCount, weightedLiterals) && readInts(weightCount, weightLengths);
+    for (Int i = 0; complete && i < constraintCount; i++)
+        complete = offsets[i] <= offsets[i + 1] && (relations[i] == Int(PbRelation::LEQUAL) || relations[i] == Int(PbRelation::EQUAL));
+    vector<vector<Number>> weights;  // per weighted literal, one per lane
+    for (Int i = 0; complete && i < weightCount; i++) {
+        const char* weight = readBytes(weightLengths[i]);
+        complete = weight != nullptr;
+        if (!complete) break;
+        weights.emplace_back();
+        std::istringstream laneStream(string(weight, weightLengths[i]));
+        string laneWeight;
+        while (laneStream >> laneWeight) weights.back().push_back(Number(laneWeight));
+        complete = !weights.back().empty() && weights.back().size() == weights.front().size();
+    }
+    if (!complete) {
+        showWarning("ignoring truncated cache file '" + cachePath + "'");
+        return false;
+    }
+
+    vector<PbRelation> constraintRelations;
+    for (Int relation : relations)
+        constraintRelations.push_back(PbRelation(relation));
+    constraints.assign(std::move(offsets), std::move(literals), std::move(coefs), std::move(constraintRelations), std::move(constraintLimits));
+    apparentVars = vars;
+    declaredVarCount = header[6];
+    apparentVarCount = header[7];
+    this->weightFormat = WeightFormat(key.weightFormat);
+    literalWeights.clear();
+    laneWeights.assign(weightCount > 0 && weights.front().size() > 1 ? weights.front().size() : 0, Map<Int, Number>());
+    for (Int i = 0; i < weightCount; i++) {
+        literalWeights[weightedLiterals[i]] = weights[i].front();
+        for (Int lane = 0; lane < laneWeights.size(); lane++) laneWeights[lane][weightedLiterals[i]] = weights[i][lane];
+    }
+
+    if (verbosityLevel >= 1) {
+        util::printRow("cachedVarCount", apparentVars.size());
+        util::printRow("cachedClauseCount", constraints.size());
+    }
+    return true;
 }
 
+void Pbf::writeCache(const string& cachePath, const PbfCacheKey& key) const {
+    if (key.sourceSize < 0) {
+        showWarning("input is not a regular file; not writing cache file '" + cachePath + "'");
+        return;
+    }
+
+    vector<Int> ints = {CACHE_VERSION, key.sourceSize, key.sourceModificationTime, key.weightFormat, key.preprocessed,
+                        key.multiplePrecision, declaredVarCount, apparentVarCount, constraints.size(), Int(apparentVars.size()),
+                        Int(literalWeights.size())};
+    for (const vector<Int>* array : {&constraints.getOffsetArray(), &constraints.getLiteralArray(), &constraints.getCoefficientArray()})
+        ints.insert(ints.end(), array->begin(), array->end());
+    for (PbRelation relation : constraints.getRelationArray())
+        ints.push_back(Int(relation));
+    ints.insert(ints.end(), constraints.getLimitArray().begin(), constraints.getLimitArray().end());
+    ints.insert(ints.end(), apparentVars.begin(), apparentVars.end());
+
+    string weightText;
+    vector<Int> weightLengths;
+    auto getWeightText = [](const Number& weight) {
+        if (multiplePrecision) return weight.quotient.get_str();
+        std::ostringstream weightStream;
+        weightStream << std::setprecision(std::numeric_limits<Float>::max_digits10) << weight.fraction;
+        return weightStream.str();
+    };
+    for (const std::pair<const Int, Number>& literalWeight : literalWeights) {
+        ints.push_back(literalWeight.first);
+        string weight = getWeightText(literalWeight.second);
+        for (Int lane = 1; lane < laneWeights.size(); lane++) weight += " " + getWeightText(laneWeights[lane].at(literalWeight.first));
+        weightLengths.push_back(weight.size());
+        weightText += weight;
+    }
+    ints.insert(ints.end(), weightLengths.begin(), weightLengths.end());
+
+    string tempPath = cachePath + "." + to_string(getpid());  // renamed into place so concurrent runs never read half a cache
+    std::ofstream outputStream(tempPath, std::ios::binary);
+    outputStream.write(CACHE_MAGIC.data(), CACHE_MAGIC.size());
+    outputStream.write(reinterpret_cast<const char*>(ints.data()), ints.size() * sizeof(Int));
+    outputStream.write(weightText.data(), weightText.size());
+    outputStream.close();
+    if (!outputStream || std::rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        showWarning("unable to write cache file '" + cachePath + "'");
+        return;
+    }
+    printComment("Wrote cache file '" + cachePath + "'", 1);
+}
+
+Pbf::Pbf() {}
+
 Pbf::Pbf(const string& filePath, WeightFormat weightFormat) {
     printComment("Reading PBF formula...", 1);
 
-    std::ifstream inputFileStream(filePath);  // variable will be destroyed if it goes out of scope
-    std::istream* inputStream;
     if (filePath == STDIN_CONVENTION) {
-        inputStream = &std::cin;
-
         printThickLine();
         printComment("Getting cnf from stdin... (end input with 'Enter' then 'Ctrl d')");
-    } else {
-        if (!inputFileStream.is_open()) {
-            showError("unable to open file '" + filePath + "'");
-        }
-        inputStream = &inputFileStream;
     }
+    TimePoint parseStartTime = util::getTimePoint();
+    InputBuffer inputBuffer(filePath);  // words below point into it
+    LineTokenizer lineTokenizer(inputBuffer);
+
     Int declaredConstraintCount = DUMMY_MIN_INT;
     Int processedConstraintCount = 0;
     this->weightFormat = weightFormat;
 
     Int lineIndex = 0;
 
-    string line;
-    while (std::getline(*inputStream, line)) {
+    std::string_view line;
+    vector<std::string_view> words;  // reused by every line
+    while (lineTokenizer.nextLine(line, words)) {
         lineIndex++;
-        std::istringstream inputStringStream(line);
-
-        if (verbosityLevel >= 4) printComment("Line " + to_string(lineIndex) + "\t" + line);
 
-        vector<string> words;
-        std::copy(std::istream_iterator<string>(inputStringStream), std::istream_iterator<string>(), std::back_inserter(words));
+        if (verbosityLevel >= 4) printComment("Line " + to_string(lineIndex) + "\t" + string(line));
 
         Int wordCount = words.size();
         if (wordCount < 1) continue;
 
         bool endLineFlag = false;
-        const string& startWord = words.at(0);
+        std::string_view startWord = words.at(0);
         
         // judge "min:" for opb
         if (startWord == COMMENT_WORD || startWord.at(0) == COMMENT_WORD.at(0) || startWord == "min:") {  // "*"
             if(wordCount < 5) continue;
-            const string &declareV = words.at(1);
-            if (declareV == COMMENT_VARIABLE_WORD) declaredVarCount = std::stoll(words.at(2));
-            const string &declareC = words.at(3);
-            if (declareC == COMMENT_CONSTRAINT_WORD) declaredConstraintCount = std::stoll(words.at(4));
+            if (words.at(1) == COMMENT_VARIABLE_WORD) declaredVarCount = util::parseInt(words.at(2), lineIndex);
+            if (words.at(3) == COMMENT_CONSTRAINT_WORD) declaredConstraintCount = util::parseInt(words.at(4), lineIndex);
         } else if(startWord == WEIGHT_WORD) { // weight line
             if(weightFormat == WeightFormat::UNWEIGHTED) continue;
                 // util::showError("Wrong weighted option");
-            if(wordCount == 3) {
-                string var = words.at(1);                 // now i = i+1
+            if(wordCount >= 3) {  // one weight per lane
+                std::string_view var = words.at(1);       // now i = i+1
                 if (var.at(0) != VARIABLE_WORD) showError("Wrong Variable format");
-                Int literal = std::stoll(var.substr(1));
-                // Float weight = std::stod(words.at(2));
-                literalWeights[literal] = Number(words.at(2));
+                Int literal = util::parseInt(var.substr(1), lineIndex);
+                Int laneCount = wordCount - 2;
+                if (laneWeights.empty() && laneCount > 1 && literalWeights.empty()) laneWeights.resize(laneCount);
+                if (laneCount != getLaneCount()) {
+                    showError("weight line lists " + to_string(laneCount) + " weights, not " + to_string(getLaneCount()) + " -- line " + to_string(lineIndex));
+                }
+                literalWeights[literal] = Number(string(words.at(2)));
+                for (Int lane = 0; lane < laneWeights.size(); lane++) laneWeights[lane][literal] = Number(string(words.at(lane + 2)));
             } else {
                 util::showWarning("Wrong weight format");
             }
@@ -342,40 +598,32 @@ Pbf::Pbf(const string& filePath, WeightFormat weightFormat) {
             vector<Int> coefficient;
             Int limit;
             for (Int i = 0; i < wordCount; i++) {
-                if(endLineFlag && i != wordCount - 1) showError("External words after relation limit " + words.at(i));
+                if(endLineFlag && i != wordCount - 1) showError("External words after relation limit " + string(words.at(i)));
 
-                const string &nowWord = words.at(i);
+                std::string_view nowWord = words.at(i);
                 if(nowWord == EQUAL_WORD) {                     // == only need format
-                    // limit = std::stoll(words.at(++i));          // now i = i+1
-                    // util::formatConstraint(clause, coefficient, limit);
-                    // addConstraint(clause, coefficient, limit);
-                    // util::inverseConstraint(clause, coefficient, limit);
-                    // addConstraint(clause, coefficient, limit);
-                    // endLineFlag = true;
-
-                    limit = std::stoll(words.at(++i));          // now i = i+1
+                    limit = util::parseInt(words.at(++i), lineIndex);  // now i = i+1
                     util::formatConstraint(clause, coefficient, limit);
-                    addConstraint(clause, coefficient, EQUAL_WORD, limit); // !! == option
+                    addConstraint(clause, coefficient, PbRelation::EQUAL, limit); // !! == option
                     endLineFlag = true;
                 } else if(nowWord == GEQUAL_WORD) {             // >= need inverse
-                    limit = std::stoll(words.at(++i));          // now i = i+1
+                    limit = util::parseInt(words.at(++i), lineIndex);  // now i = i+1
                     util::inverseConstraint(clause, coefficient, limit);
-                    addConstraint(clause, coefficient, LEQUAL_WORD, limit);     // inverse to <=
+                    addConstraint(clause, coefficient, PbRelation::LEQUAL, limit);     // inverse to <=
                     endLineFlag = true;
                 } else if(nowWord == LEQUAL_WORD) {             // <= need format
-                    limit = std::stoll(words.at(++i));          // now i = i+1
+                    limit = util::parseInt(words.at(++i), lineIndex);  // now i = i+1
                     util::formatConstraint(clause, coefficient, limit);
-                    addConstraint(clause, coefficient, LEQUAL_WORD, limit);
+                    addConstraint(clause, coefficient, PbRelation::LEQUAL, limit);
                     endLineFlag = true;
                 } else if(nowWord == END_LINE_WORD){
                     if(!endLineFlag) showError("end line without completion constraint");
                     processedConstraintCount++;
                 } else {                                        // coefficient & variable
-                    Int coef = std::stoll(words.at(i));
-                    string var = words.at(++i);                 // now i = i+1
+                    Int coef = util::parseInt(nowWord, lineIndex);
+                    std::string_view var = words.at(++i);       // now i = i+1
                     if (var.at(0) != VARIABLE_WORD) showError("Wrong Variable format");
-                    Int literal = std::stoll(var.substr(1));
-                    // cout << "Var " << var << " substr " << var.substr(1) << " literal " << literal << std::endl;
+                    Int literal = util::parseInt(var.substr(1), lineIndex);
                     if (literal > declaredVarCount || literal < -declaredVarCount) {
                         showError("literal '" + to_string(literal) + "' is inconsistent with declared var count '" + to_string(declaredVarCount) + "' -- line " + to_string(lineIndex));
                     }
@@ -403,22 +651,10 @@ Pbf::Pbf(const string& filePath, WeightFormat weightFormat) {
         util::printRow("apparentVarCount", apparentVars.size());
         util::printRow("declaredClauseCount", declaredConstraintCount);
         util::printRow("apparentClauseCount", processedConstraintCount);
+        util::printRow("parseSeconds", util::getSeconds(parseStartTime));
     }
 
     if (verbosityLevel >= 3) {
         printConstraints();
     }
 }
-
-Pbf::Pbf(const vector<vector<Int>>& clauses, const vector<vector<Int>> &coefficients, const vector<string> &options, const vector<Int> &limits) {
-    this->clauses = clauses;
-    this->coefficients = coefficients;
-    this->options = options;
-    this->limits = limits;
-
-    for (const vector<Int>& clause : clauses) {
-        for (Int literal : clause) {
-            updateApparentVars(literal);
-        }
-    }
-}
@@ -34,9 +34,6 @@ Int Preprocessor::getCoefSum(Int consIndex) const {
     // Int sum = 0, vecSize = _literals[consIndex].size();
     Int sum = 0;
     for (const Int& lit : _literals[consIndex]) {
-
-        if (_delLiterals[consIndex].count(lit) > 0)  continue;
-
         if (_coefficients[consIndex].at(lit) <= 0) {
             showError("Wrong coefficient value");
         } else {
@@ -69,11 +66,10 @@ void Preprocessor::removeConstraint(Int consIndex) {
 
     _upperBound.erase(_upperBound.begin() + consIndex);
     _lowerBound.erase(_lowerBound.begin() + consIndex);
-    _options.erase(_options.begin() + consIndex);
+    _relations.erase(_relations.begin() + consIndex);
 
     _curCoefSum.erase(_curCoefSum.begin() + consIndex);
     _curCoefVal.erase(_curCoefVal.begin() + consIndex);
-    _delLiterals.erase(_delLiterals.begin() + consIndex);
 
     _constraintCnt--;
 
@@ -101,22 +97,22 @@ bool Preprocessor::judgeTruthConstraint(Int consIndex) const {
             && _curCoefVal[consIndex] + _curCoefSum[consIndex] <= _upperBound[consIndex]);
 }
 
-void Preprocessor::delLitFromCons(Int consIndex, Int lit, bool trueAssign) {
-    // cout << "Delete " << lit << " from " << consIndex << endl;
-    Int coef = _coefficients[consIndex][lit];
-    _curCoefSum[consIndex] -= coef;
-    _curCoefVal[consIndex] += trueAssign ? coef : 0;
-    _delLiterals[consIndex].insert(lit);
-}
-
-void Preprocessor::rstLitFromCons(Int consIndex, Int lit, bool trueAssign) {
-    assert(_delLiterals[consIndex].count(lit) > 0);
-    // cout << "Reset " << lit << " from " << consIndex << endl;
-    Int coef = _coefficients[consIndex][lit];
-    _curCoefSum[consIndex] += coef;
-    _curCoefVal[consIndex] -= trueAssign ? coef : 0;
-    // _delLiterals[consIndex].erase(lit);
-    // !!! erase out of this funtion
+// implied constraints are only marked during vivification, so constraint indices stay valid
+void Preprocessor::buildPropagator() {
+    _propagator = Propagator(_apparentVarCnt);
+    vector<Int> clause;
+    vector<Int> coeff;
+    for (Int consIndex = 0; consIndex < _constraintCnt; consIndex++) {
+        clause.clear();
+        coeff.clear();
+        for (const auto& [lit, coef] : _coefficients[consIndex]) {
+            clause.push_back(lit);
+            coeff.push_back(coef);
+        }
+        _propagator.addConstraint(clause, coeff, _lowerBound[consIndex], _upperBound[consIndex]);
+    }
+    _propagator.buildOccurrences();
+    _implied.assign(_constraintCnt, false);
 }
 
 void Preprocessor::printConstraint(Int consIndex) const {
@@ -209,7 +205,7 @@ bool Preprocessor::getOneModel(Int consIndex, vector<Int> &model) const {
 void Preprocessor::judgeSize() {
     // cout << _literals.size() << " " << _coefficients.size() << " " << _upperBound.size() << " " << _lowerBound.size() << " " << _constraintCnt << std::endl;
     if (_coefficients.size() != _constraintCnt ||
-        _options.size() != _constraintCnt ||
+        _relations.size() != _constraintCnt ||
         _upperBound.size() != _constraintCnt ||
         _lowerBound.size() != _constraintCnt) showError("Wrong size in preprocessor");
 }
@@ -257,14 +253,13 @@ void Preprocessor::addConstraint(const vector<Int>& nLiteral, const vector<Int>&
 
     _curCoefSum.push_back(0);
     _curCoefVal.push_back(0);
-    _delLiterals.push_back(Set<Int>());
 
     for (Int i = 0, sz = nLiteral.size(); i < sz; i++) {
        addMonomial(_constraintCnt, nLiteral[i], nCoef[i]); 
     }
 
-    if (lb == ub) _options.push_back(EQUAL_WORD);
-    else _options.push_back(LEQUAL_WORD);
+    if (lb == ub) _relations.push_back(PbRelation::EQUAL);
+    else _relations.push_back(PbRelation::LEQUAL);
 
     _constraintCnt++; 
 
@@ -416,88 +411,8 @@ void Preprocessor::propagateSize2EqConstraint(Int i) {  // x_1 + x_2 = 1
 */
 }
 
-Dd Preprocessor::constructDd(const vector<Pair<Int, Pair<Int, Int> > >& clausePbfVarOrder,
-                         vector<Mymap<Pair<Int, Int>, Int, HashFunc, EqualKey> >& itervalToDdIndex,
-                         vector<Dd>& structedDd,
-                         const Int& index,
-                         Int& lf,
-                         Int& rt,
-                         const Int& limit) const {
-    for (auto p : itervalToDdIndex[index]) {
-        if (p.first.first <= limit && limit <= p.first.second) {
-            lf = p.first.first;
-            // rt = p.first.first;
-            rt = p.first.second;            // fix a bug?
-            return structedDd[p.second];
-        }
-    }
-    Int literal = clausePbfVarOrder[index].second.first;
-    Int cnfVar = util::getCnfVar(literal);
-    Int varCoef = clausePbfVarOrder[index].second.second;
-    Int ddVar = clausePbfVarOrder[index].first;
-    Int tlf, trt, flf, frt;
-    Dd Bf = constructDd(clausePbfVarOrder, itervalToDdIndex, structedDd, index + 1, flf, frt, limit);
-    Dd Bt = constructDd(clausePbfVarOrder, itervalToDdIndex, structedDd, index + 1, tlf, trt, limit - varCoef);
-    Dd B  = Dd::getOneDd(mgr);
-
-    if (tlf == flf && trt == frt) {
-        B = Bt, lf = tlf + varCoef, rt = trt;
-    } else {
-        if (util::isPositiveLiteral(literal)) {
-            B = Dd::getVarDd(ddVar, mgr).getIte(Bt, Bf);
-        } else {
-            B = Dd::getVarDd(ddVar, mgr).getIte(Bf, Bt);
-        }
-        lf = std::max(flf, tlf + varCoef);
-        rt = std::min(frt, trt + varCoef);
-    }
-    structedDd.push_back(B);
-    itervalToDdIndex[index][{lf, rt}] = structedDd.size() - 1;
-    return B;
-}
-
-Dd Preprocessor::constructDdEq(const vector<Pair<Int, Pair<Int, Int> > >& clausePbfVarOrder,
-                         vector<Map<Int, Int> >& valueToDdIndex,
-                         vector<Dd>& structedDd,
-                         const Int& sufCoefSum,
-                         const Int& index,
-                         const Int& limit) const {
-
-    if (valueToDdIndex[index].count(limit)) {
-        return structedDd[valueToDdIndex[index][limit]];
-    } else if (limit < 0) {             // UNSAT
-        return Dd::getZeroDd(mgr);
-    } else if (limit > sufCoefSum) {    // UNSAT
-        return Dd::getZeroDd(mgr);
-    }
-
-    Int literal = clausePbfVarOrder[index].second.first;
-    Int cnfVar = util::getCnfVar(literal);
-    Int varCoef = clausePbfVarOrder[index].second.second;
-    Int ddVar = clausePbfVarOrder[index].first;
-    
-    Dd Bf = constructDdEq(clausePbfVarOrder, valueToDdIndex, structedDd, 
-                            sufCoefSum - varCoef, index + 1, limit);
-    Dd Bt = constructDdEq(clausePbfVarOrder, valueToDdIndex, structedDd, 
-                            sufCoefSum - varCoef, index + 1, limit - varCoef);
-    Dd B  = Dd::getOneDd(mgr);
-
-
-    if (util::isPositiveLiteral(literal)) {
-        B = Dd::getVarDd(ddVar, mgr).getIte(Bt, Bf);
-    } else {
-        B = Dd::getVarDd(ddVar, mgr).getIte(Bf, Bt);
-    }
-        
-    structedDd.push_back(B);
-    valueToDdIndex[index][limit] = structedDd.size() - 1;
-    return B;
-}
-
-
 //  这里需要对出现的 var 进行 cnf 序的重新排列，然后按照 order 来构建 BDD
-Dd Preprocessor::getConstraintDd(const Set<Int>& clause, const Map<Int, Int>& coefficient, const string& option, const Int& limit) const {
-    Int clauseVarSize = clause.size();
+Dd Preprocessor::getConstraintDd(const Set<Int>& clause, const Map<Int, Int>& coefficient, PbRelation relation, Int limit) const {
     vector<Pair<Int, Pair<Int, Int> > > clausePbfVarOrder;
     for (const Int& lit : clause) {
         Int var = util::getCnfVar(lit);
@@ -505,72 +420,36 @@ Dd Preprocessor::getConstraintDd(const Set<Int>& clause, const Map<Int, Int>& co
         clausePbfVarOrder.push_back({var, {lit, coef}});
     }
 
-    std::sort(clausePbfVarOrder.begin(), clausePbfVarOrder.end());  // <ddVar, cnfVar>
-
-    if(option == LEQUAL_WORD) {
-        vector<Mymap<Pair<Int, Int>, Int, HashFunc, EqualKey> > itervalToDdIndex(clauseVarSize + 1);
-        vector<Dd> structedDd;
-
-        structedDd.push_back(Dd::getZeroDd(mgr));  // false
-        structedDd.push_back(Dd::getOneDd(mgr));   // true
-
-        Int coefficientSum = 0;
-        for (int i = clauseVarSize - 1; i >= 0; i--) {
-            coefficientSum += clausePbfVarOrder[i].second.second;
-            itervalToDdIndex[i][{DUMMY_MIN_INT, -1}] = 0;
-            itervalToDdIndex[i][{coefficientSum, DUMMY_MAX_INT}] = 1;
-        }
-        itervalToDdIndex[clauseVarSize][{DUMMY_MIN_INT, -1}] = 0;
-        itervalToDdIndex[clauseVarSize][{0, DUMMY_MAX_INT}] = 1;
-        Int lf, rt;
-
-        return constructDd(clausePbfVarOrder, itervalToDdIndex, structedDd, 0, lf, rt, limit);
-    } else if (option == EQUAL_WORD) {
-        vector<Map<Int, Int> > valueToDdIndex(clauseVarSize + 1);
-        vector<Dd> structedDd;
-        structedDd.push_back(Dd::getZeroDd(mgr));  // false
-        structedDd.push_back(Dd::getOneDd(mgr));   // true
-        Int coefficientSum = 0;
-        for (int i = clauseVarSize - 1; i >= 0; i--) {
-            coefficientSum += clausePbfVarOrder[i].second.second;
-        }
-        valueToDdIndex[clauseVarSize][0] = 1; // present 0 = 0 is always true.
-        return constructDdEq(clausePbfVarOrder, valueToDdIndex, structedDd, coefficientSum, 0, limit); 
-    } else {
-        showError("Undefined option when getConstraintDd");
-        return Dd::getOneDd(mgr);
-    }
+    return PbDdBuilder(clausePbfVarOrder, mgr).getDd(relation, limit);
 }
 
 // pbf is formated as ai * xi <= K, where ai and K >0
 Preprocessor::Preprocessor(const Pbf& pbf) {
-    const vector<vector<Int> >& clauses = pbf.getClauses();
-    const vector<vector<Int> >& coefficients = pbf.getCoefficients();
+    const PbConstraintStore& constraints = pbf.getConstraints();
 
-    this->_options = pbf.getOptions();
-    this->_upperBound = pbf.getLimits();
+    this->_relations = constraints.getRelationArray();
+    this->_upperBound = constraints.getLimitArray();
     this->_apparentVarCnt = pbf.getApparentVarCount();
 
-    _constraintCnt = clauses.size();
+    _constraintCnt = constraints.size();
 
     _literals.resize(_constraintCnt);
     _coefficients.resize(_constraintCnt);
     _lowerBound.resize(_constraintCnt);
     _curCoefSum.resize(_constraintCnt);
     _curCoefVal.resize(_constraintCnt);
-    _delLiterals.resize(_constraintCnt);
 
     // init _literals & _coefficients
     for (Int consIndex = 0; consIndex < _constraintCnt ; consIndex++) {
-        if (_options[consIndex] == EQUAL_WORD) _lowerBound[consIndex] = _upperBound[consIndex];
-        else if (_options[consIndex] == LEQUAL_WORD) _lowerBound[consIndex] = 0;
-        else showWarning("Wrong option in preprocessor");
+        _lowerBound[consIndex] = _relations[consIndex] == PbRelation::EQUAL ? _upperBound[consIndex] : 0;
 
         _curCoefSum[consIndex] = 0;     // sum of unassigned literal's coef
         _curCoefVal[consIndex] = 0;     // sum of assigned literal's coef
         
-        for (Int litIndex = 0, vecSize = clauses[consIndex].size(); litIndex < vecSize; litIndex++) {
-            addMonomial(consIndex, clauses[consIndex][litIndex], coefficients[consIndex][litIndex]);
+        Span<Int> clause = constraints.getLiterals(consIndex);
+        Span<Int> coefficient = constraints.getCoefficients(consIndex);
+        for (Int litIndex = 0, vecSize = clause.size(); litIndex < vecSize; litIndex++) {
+            addMonomial(consIndex, clause[litIndex], coefficient[litIndex]);
         }
     }
 
@@ -587,9 +466,9 @@ void Preprocessor::output() {
         for (const Int& lit : _literals[consIndex]) {
             cout << "+" << _coefficients[consIndex][lit] << " x" << lit << " ";
         }
-        cout << _options[consIndex] << " " << _upperBound[consIndex] << " ;" << std::endl;
+        cout << util::getRelationWord(_relations[consIndex]) << " " << _upperBound[consIndex] << " ;" << std::endl;
 
-        if (_options[consIndex] == EQUAL_WORD || _lowerBound[consIndex] == 0 || _lowerBound[consIndex] == _upperBound[consIndex]) continue;
+        if (_relations[consIndex] == PbRelation::EQUAL || _lowerBound[consIndex] == 0 || _lowerBound[consIndex] == _upperBound[consIndex]) continue;
 
         for (const Int& lit : _literals[consIndex]) {
             cout << "+" << _coefficients[consIndex][lit] << " x" << lit << " ";
@@ -598,50 +477,9 @@ void Preprocessor::output() {
     }
 }
 
-// do not erase var during propagation
-bool Preprocessor::propagateLit(Int lit, Int skipConsIndex) {
-    // cout << "Propagate Lit: " << lit << endl;
-    for (Int consIndex = 0; consIndex < _constraintCnt; consIndex++) {
-        if (consIndex == skipConsIndex) continue;
-        assert(_delLiterals[consIndex].count(lit) == 0);
-
-        if (judgeTruthConstraint(consIndex)) continue;
-
-        if (_literals[consIndex].count(lit) > 0) {          // lit == true
-            delLitFromCons(consIndex, lit, true);
-        }
-        else if (_literals[consIndex].count(-lit) > 0) {   // lit in cons is fasle
-            delLitFromCons(consIndex, -lit, false);
-        } 
-
-        // find conflict
-        if (_curCoefVal[consIndex] + 0 > _upperBound[consIndex]) return false;  // all coef > 0
-        if (_curCoefVal[consIndex] + _curCoefSum[consIndex] < _lowerBound[consIndex]) return false;
-
-        // find conflict
-        if (_delLiterals.size() == _literals[consIndex].size()) {          // deleted all vars  lb <= curCoefVal <= ub
-            if (!judgeTruthConstraint(consIndex)) return false;
-        }
-    }
-    // no conflict
-    return true;
-}
-
-bool Preprocessor::rstPropagateLit(Int lit, Int skipConsIndex) {
-    // cout << "Reset Propagate Lit: " << lit << endl;
-    for (Int consIndex = 0; consIndex < _constraintCnt; consIndex++) {
-        if (consIndex == skipConsIndex) continue;
-
-        if (_delLiterals[consIndex].count(lit) > 0) {          // lit == true
-            rstLitFromCons(consIndex, lit, true);
-            _delLiterals[consIndex].erase(lit);
-        }
-        else if (_delLiterals[consIndex].count(-lit) > 0) {   // lit in cons is fasle
-            rstLitFromCons(consIndex, -lit, false);
-            _delLiterals[consIndex].erase(-lit);
-        } 
-    }
-    return true;
+// also assigns every literal implied through the other active constraints
+bool Preprocessor::propagateLit(Int lit) {
+    return _propagator.assign(lit) && _propagator.propagate();
 }
 
 /** 
@@ -649,12 +487,15 @@ bool Preprocessor::rstPropagateLit(Int lit, Int skipConsIndex) {
  * @return true consIndex can been removed, while false can not
 */
 bool Preprocessor::judgeImplication(const Int& consIndex) {
-    Dd B = getConstraintDd(_literals[consIndex], _coefficients[consIndex], _options[consIndex], _upperBound[consIndex]);
+    Dd B = getConstraintDd(_literals[consIndex], _coefficients[consIndex], _relations[consIndex], _upperBound[consIndex]);
     // B.writeDotFile(mgr, "./dot/");
     Set <Int> eqCnfLits;
 
     // return visCnfAssignOnDd(B, eqCnfLits, consIndex);       // version 1 - judge on leaf
-    return visAndJudgeAssignOnDd(B, consIndex);             // vsrsion 2 - judge while defs
+    _propagator.setActive(consIndex, false);               // cons[consIndex] must not refute its own assignments
+    bool implied = visAndJudgeAssignOnDd(B, consIndex);     // vsrsion 2 - judge while defs
+    _propagator.setActive(consIndex, !implied);            // implied constraints no longer take part
+    return implied;
 
     // if (visCnfAssignOnDd(B, eqCnfLits, consIndex) != visAndJudgeAssignOnDd(B, consIndex)) {
         // B.writeDotFile(mgr);
@@ -714,23 +555,22 @@ bool Preprocessor::visAndJudgeAssignOnDd(const Dd& dd, const Int& consIndex) {
     Int var = dd.getTopVar();
     assert(var >= 0);
 
-    if(!propagateLit(var, consIndex)) {     // have conflict, whatever sat or unsat assignment
+    Int trailSize = _propagator.getTrailSize();
+    if(!propagateLit(var)) {     // have conflict, whatever sat or unsat assignment
         // cout << "Find conflict while propagate: " << var << endl;
-        // rstPropagateLit(var, consIndex);
     } else if(!visAndJudgeAssignOnDd(dd.getThen(), consIndex)) {
-        rstPropagateLit(var, consIndex);
+        _propagator.backtrack(trailSize);
         return false;                       // false - end dfs
     }
-    rstPropagateLit(var, consIndex);
+    _propagator.backtrack(trailSize);
 
-    if(!propagateLit(-var, consIndex)) {    // have conslict
+    if(!propagateLit(-var)) {    // have conslict
         // cout << "Find conflict while propagate: " << -var << endl;
-        // rstPropagateLit(-var, consIndex);
     } else if(!visAndJudgeAssignOnDd(dd.getElse(), consIndex)) {
-        rstPropagateLit(-var, consIndex);
+        _propagator.backtrack(trailSize);
         return false;
     }
-    rstPropagateLit(-var, consIndex);
+    _propagator.backtrack(trailSize);
 
     return true;
 }
@@ -738,37 +578,37 @@ bool Preprocessor::visAndJudgeAssignOnDd(const Dd& dd, const Int& consIndex) {
 // we need all unsat assignments find conflict
 bool Preprocessor::judgeCnfAssign(const Set<Int>& cnfLits, const Int& consIndex) {
     bool conflict = false;
+    Int trailSize = _propagator.getTrailSize();
 
     for (const Int& lit : cnfLits) {
-        if (!propagateLit(lit, consIndex)) {
+        if (!propagateLit(lit)) {
             conflict = true;
             break;
         }
     }
 
-    for (Int i = 0; i < _constraintCnt; i++) {
-        for (const Int& lit : _delLiterals[i]) {
-            rstLitFromCons(i, lit, (cnfLits.count(lit) > 0));
-        }
-        _delLiterals[i].clear();
-    }
+    _propagator.backtrack(trailSize);
     // cout << "judge Cnf Assign: " << conflict << endl;
     return conflict;
 }
 
-void Preprocessor::doVivif(Pbf& pbf) {
-    TimePoint vivifStartTime = util::getTimePoint();;
-    Int removeCnt = 0;
+Int Preprocessor::getLiveVarCount() const {
+    vector<bool> live(std::max(_apparentVarCnt, Int(0)) + 1, false);
+    Int liveCnt = 0;
     for (Int consIndex = 0; consIndex < _constraintCnt; consIndex++) {
-        if (_literals[consIndex].size() >= 20) continue;
-        if (judgeImplication(consIndex)) {
-            // cout << "Remove constraint: "; printConstraint(consIndex);
-            removeConstraint(consIndex);
-            consIndex--;
-            removeCnt++;
+        for (const Int& lit : _literals[consIndex]) {
+            Int var = std::abs(lit);
+            if (var >= live.size()) live.resize(var + 1, false);
+            if (!live[var]) {
+                live[var] = true;
+                liveCnt++;
+            }
         }
     }
+    return liveCnt;
+}
 
+void Preprocessor::writePbf(Pbf &pbf) const {
     pbf.clearConstraints();
     vector<Int> clause;
     vector<Int> coeff;
@@ -781,20 +621,73 @@ void Preprocessor::doVivif(Pbf& pbf) {
 
         for (const Int& lit : _literals[consIndex]) {
             clause.push_back(lit);
-            coeff.push_back(_coefficients[consIndex][lit]);
+            coeff.push_back(_coefficients[consIndex].at(lit));
         }
         
-        pbf.addConstraint(clause, coeff, _options[consIndex], _upperBound[consIndex]);
+        pbf.addConstraint(clause, coeff, _relations[consIndex], _upperBound[consIndex]);
+    }
+}
+
+vector<PreprocessPass> Preprocessor::getPasses(const string &passList) {
+    vector<PreprocessPass> passes;
+    std::istringstream passStream(passList);
+    string entry;
+    while (std::getline(passStream, entry, ',')) {
+        if (entry.empty()) continue;
+
+        PreprocessPass pass;
+        size_t colon = entry.find(':');
+        pass.name = entry.substr(0, colon);
+        if (colon != string::npos) {
+            try {
+                pass.timeLimit = std::stold(entry.substr(colon + 1));
+            } catch (const std::exception&) {
+                showError("no such preprocess pass time limit: " + entry);
+            }
+            if (pass.timeLimit < 0) showError("no such preprocess pass time limit: " + entry);
+        }
+        if (pass.name != "backbone" && pass.name != "probe" && pass.name != "vivify") showError("no such preprocess pass: " + pass.name);
+        passes.push_back(pass);
     }
+    return passes;
+}
 
-    printComment("Preprocess: vivification delete Constraints num = " + to_string(removeCnt) + " UseTime: " + to_string(util::getSeconds(vivifStartTime)));
+// timeLimit is checked between constraints; constraints not reached stay in the formula
+void Preprocessor::doVivif(Pbf& pbf, Float timeLimit) {
+    TimePoint vivifStartTime = util::getTimePoint();
+    Int skipCnt = 0;
+    buildPropagator();
+    for (Int consIndex = 0; consIndex < _constraintCnt; consIndex++) {
+        if (timeLimit > 0 && util::getSeconds(vivifStartTime) >= timeLimit) {
+            printComment("Preprocess: vivification reached time limit, untried Constraints num = " + to_string(_constraintCnt - consIndex));
+            break;
+        }
+        if (_literals[consIndex].size() >= vivifyLiteralLimit) {
+            skipCnt++;
+            continue;
+        }
+        if (judgeImplication(consIndex)) {
+            // cout << "Remove constraint: "; printConstraint(consIndex);
+            _implied[consIndex] = true;
+        }
+    }
+    for (Int consIndex = _constraintCnt - 1; consIndex >= 0; consIndex--) {
+        if (_implied[consIndex]) removeConstraint(consIndex);
+    }
+    _propagator = Propagator();
+    _implied.clear();
+    if (skipCnt > 0) printComment("Preprocess: vivification skipped long Constraints num = " + to_string(skipCnt));
+
+    writePbf(pbf);
 }
 
-void Preprocessor::doBackBone(Pbf &pbf) {
-    TimePoint backBoneStartTime = util::getTimePoint();
+// the backbone search stops after timeLimit or backboneTimeLimit, whichever is set and smaller
+void Preprocessor::doBackBone(Pbf &pbf, Float timeLimit) {
+    if (timeLimit <= 0 || (backboneTimeLimit > 0 && backboneTimeLimit < timeLimit)) timeLimit = backboneTimeLimit;
+
     vector<Int> backBone;
-    rsSolver::getBackBone(pbf, backBone);
-    printComment("Preprocess: Find Backbone size = " + to_string(backBone.size()) + " UseTime: " + to_string(util::getSeconds(backBoneStartTime)));
+    rsSolver::getBackBone(pbf, backBone, timeLimit);
+    printComment("Preprocess: Find Backbone size = " + to_string(backBone.size()));
 
     for (Int i = 0; i < backBone.size(); i++) {
         addConstraint({backBone[i]}, {1}, 1, 1);
@@ -803,34 +696,188 @@ void Preprocessor::doBackBone(Pbf &pbf) {
 
     removeTruthConstraints();
 
-    pbf.clearConstraints();
-    vector<Int> clause;
-    vector<Int> coeff;
+    writePbf(pbf);
+}
 
-    clause.reserve(pbf.getApparentVarCount());
-    coeff.reserve(pbf.getApparentVarCount());
-    for (Int consIndex = 0; consIndex < _constraintCnt; consIndex++) {
-        clause.clear();
-        coeff.clear();
+// parents[var] is a literal of the same class (var itself at the root), so a class is a tree with signed edges
+Int Preprocessor::findLiteral(vector<Int>& parents, Int lit) const {
+    Int var = std::abs(lit);
+    if (parents[var] == var) return lit;
+    Int root = findLiteral(parents, parents[var]);
+    parents[var] = root;    // path compression
+    return lit > 0 ? root : -root;
+}
 
+// a*x + b*(-x) = b + (a - b)*x, so opposite literals of a var merge into one term and a shift of both bounds
+void Preprocessor::substituteLiterals(const vector<Int>& substitutes) {
+    for (Int consIndex = 0; consIndex < _constraintCnt; consIndex++) {
+        bool changed = false;
         for (const Int& lit : _literals[consIndex]) {
-            clause.push_back(lit);
-            coeff.push_back(_coefficients[consIndex][lit]);
+            if (substitutes[std::abs(lit)] != 0) {
+                changed = true;
+                break;
+            }
         }
-        
-        pbf.addConstraint(clause, coeff, _options[consIndex], _upperBound[consIndex]);
+        if (!changed) continue;
+
+        Map<Int, Int> merged;
+        Int shift = 0;
+        for (const auto& [lit, coef] : _coefficients[consIndex]) {
+            Int substitute = substitutes[std::abs(lit)];
+            Int target = substitute == 0 ? lit : (lit > 0 ? substitute : -substitute);
+            if (merged.count(target) > 0) {
+                merged[target] += coef;
+            } else if (merged.count(-target) > 0) {
+                Int opposite = merged[-target];
+                merged.erase(-target);
+                shift += std::min(opposite, coef);
+                if (coef > opposite) merged[target] = coef - opposite;
+                else if (coef < opposite) merged[-target] = opposite - coef;
+            } else {
+                merged[target] = coef;
+            }
+        }
+
+        _literals[consIndex].clear();
+        _coefficients[consIndex] = merged;
+        _curCoefSum[consIndex] = 0;
+        _curCoefVal[consIndex] = 0;
+        for (const auto& [lit, coef] : merged) {
+            _literals[consIndex].insert(lit);
+            _curCoefSum[consIndex] += coef;
+        }
+        _upperBound[consIndex] -= shift;
+        _lowerBound[consIndex] = std::max(_lowerBound[consIndex] - shift, Int(0));
+    }
+}
+
+/**
+ * probes both literals of every var with unit propagation:
+ * a literal whose propagation fails is false, a literal implied by both x and -x is true,
+ * and a var y with y under x and -y under -x is equivalent to x (opposite if the signs are swapped)
+ * failed literals become unit constraints like backbone literals; equivalent vars are replaced by the class root,
+ * which takes over their weights
+*/
+void Preprocessor::doProbe(Pbf &pbf, Float timeLimit) {
+    TimePoint probeStartTime = util::getTimePoint();
+    buildPropagator();
+    Int varCnt = _propagator.getVarCount();
+
+    vector<Int> parents(varCnt + 1);
+    for (Int var = 0; var <= varCnt; var++) parents[var] = var;
+    vector<signed char> marks(varCnt + 1, 0);   // sign of each var implied by the positive probe
+    vector<Int> positiveImplied;
+    vector<Int> units;
+    Int unitCnt = 0;
+    bool unsat = false;
+
+    for (Int var = 1; var <= varCnt && !unsat; var++) {
+        if (timeLimit > 0 && util::getSeconds(probeStartTime) >= timeLimit) {
+            printComment("Preprocess: probing reached time limit, untried Variables num = " + to_string(varCnt + 1 - var));
+            break;
+        }
+        if (_propagator.getOccurrenceCount(var) == 0 || _propagator.getValue(var) != 0) continue;
+
+        Int rootSize = _propagator.getTrailSize();
+        units.clear();
+        if (!propagateLit(var)) {
+            units.push_back(-var);
+        } else {
+            positiveImplied.clear();
+            for (Int i = rootSize + 1; i < _propagator.getTrailSize(); i++) {
+                Int lit = _propagator.getTrailLiteral(i);
+                marks[std::abs(lit)] = lit > 0 ? 1 : -1;
+                positiveImplied.push_back(std::abs(lit));
+            }
+            _propagator.backtrack(rootSize);
+
+            if (!propagateLit(-var)) {
+                units.push_back(var);
+            } else {
+                for (Int i = rootSize + 1; i < _propagator.getTrailSize(); i++) {
+                    Int lit = _propagator.getTrailLiteral(i);
+                    Int implied = std::abs(lit);
+                    if (marks[implied] == 0) continue;
+                    if ((marks[implied] > 0) == (lit > 0)) {
+                        units.push_back(lit);   // implied either way
+                    } else {
+                        Int rootLit = findLiteral(parents, marks[implied] * var);  // implied ~ marks * var
+                        Int impliedRoot = findLiteral(parents, implied);
+                        if (std::abs(rootLit) != std::abs(impliedRoot)) {
+                            parents[std::abs(impliedRoot)] = impliedRoot > 0 ? rootLit : -rootLit;
+                        }
+                    }
+                }
+            }
+            for (Int implied : positiveImplied) marks[implied] = 0;
+        }
+        _propagator.backtrack(rootSize);
+
+        for (Int unit : units) {
+            unitCnt++;
+            if (!propagateLit(unit)) {
+                showWarning("probing found the formula unsatisfiable");
+                _propagator.backtrack(rootSize);
+                unsat = true;
+                break;
+            }
+        }
+    }
+
+    // root assignments become unit constraints; the other vars of their classes are implied by propagation anyway
+    vector<Int> substitutes(varCnt + 1, 0);
+    Int substituteCnt = 0;
+    for (Int var = 1; var <= varCnt; var++) {
+        Int root = findLiteral(parents, var);
+        if (root == var || _propagator.getValue(var) != 0 || _propagator.getValue(root) != 0) continue;
+        if (!pbf.substituteVar(var, root)) continue;
+        substitutes[var] = root;
+        substituteCnt++;
+    }
+    vector<Int> rootLits;
+    for (Int i = 0; i < _propagator.getTrailSize(); i++) rootLits.push_back(_propagator.getTrailLiteral(i));
+    _propagator = Propagator();
+    _implied.clear();
+
+    substituteLiterals(substitutes);
+    for (Int lit : rootLits) {
+        addConstraint({lit}, {1}, 1, 1);
+        propagateEqConstraint(_literals.size() - 1);
+    }
+    removeTruthConstraints();
+
+    printComment("Preprocess: probing found units = " + to_string(unitCnt) + " fixed Variables = " + to_string(rootLits.size()) +
+                 " substituted Variables = " + to_string(substituteCnt));
+
+    writePbf(pbf);
+
+    // a class root may lose its last constraint (x + y = 1 with y replaced by -x); it then counts as unconstrained
+    vector<bool> live(varCnt + 1, false);
+    for (Int consIndex = 0; consIndex < _constraintCnt; consIndex++) {
+        for (const Int& lit : _literals[consIndex]) live[std::abs(lit)] = true;
+    }
+    for (Int var = 1; var <= varCnt; var++) {
+        if (!live[var]) pbf.removeApparentVar(var);
     }
-    printComment("Process BackBone Done, UseTime: " + to_string(util::getSeconds(backBoneStartTime)));
 }
 
 void Preprocessor::getPreprocessedPbf(Pbf &pbf) {
-    // doBackBone(pbf);
     cout << endl;
     printComment("Start Preprocessing ...");
 
-    doBackBone(pbf);
-    // init
-    doVivif(pbf);
+    for (const PreprocessPass& pass : getPasses(preprocessPasses)) {
+        TimePoint passStartTime = util::getTimePoint();
+        Int constraintCnt = _constraintCnt;
+        Int varCnt = getLiveVarCount();
+
+        if (pass.name == "backbone") doBackBone(pbf, pass.timeLimit);
+        else if (pass.name == "probe") doProbe(pbf, pass.timeLimit);
+        else doVivif(pbf, pass.timeLimit);
+
+        printComment("Preprocess: " + pass.name + " removed Constraints num = " + to_string(constraintCnt - _constraintCnt) +
+                     " Variables num = " + to_string(varCnt - getLiveVarCount()) +
+                     " UseTime: " + to_string(util::getSeconds(passStartTime)));
+    }
     // pbf.printConstraints();
 }
 
@@ -840,7 +887,7 @@ void Preprocessor::test(int argc, char** argv){
 
     if (ddPackage == SYLVAN_PACKAGE) {  // initializes Sylvan
         cout << "Init sylvan package" << endl;
-        lace_init(1ll, 0);
+        lace_init(threadCount, 0);
         lace_startup(0, NULL, NULL);
         sylvan::sylvan_set_limits(maxMem * MEGA, tableRatio, initRatio);
         sylvan::sylvan_init_package();
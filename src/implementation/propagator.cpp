@@ -0,0 +1,144 @@
+/* inclusions *****************************************************************/
+
+#include "../interface/propagator.hpp"
+
+/* classes ********************************************************************/
+
+/* class Propagator ***********************************************************/
+
+Propagator::Propagator(Int varCount) : varCount(std::max(varCount, Int(0))) {}
+
+void Propagator::addConstraint(Span<Int> literals, Span<Int> coefficients, Int lowerBound, Int upperBound) {
+    Int coefSum = 0;
+    Int maxCoefficient = 0;
+    for (Int i = 0; i < literals.size(); i++) {
+        if (coefficients[i] <= 0) showError("Propagator needs positive coefficients");
+        termLiterals.push_back(literals[i]);
+        termCoefficients.push_back(coefficients[i]);
+        coefSum += coefficients[i];
+        maxCoefficient = std::max(maxCoefficient, coefficients[i]);
+        varCount = std::max(varCount, std::abs(literals[i]));
+    }
+    termOffsets.push_back(termLiterals.size());
+
+    upperSlacks.push_back(upperBound);
+    lowerSlacks.push_back(coefSum - lowerBound);
+    maxCoefficients.push_back(maxCoefficient);
+    activeFlags.push_back(1);
+}
+
+void Propagator::buildOccurrences() {
+    occurrenceOffsets.assign(varCount + 2, 0);
+    for (Int lit : termLiterals) occurrenceOffsets[std::abs(lit) + 1]++;
+    for (Int var = 1; var <= varCount + 1; var++) occurrenceOffsets[var] += occurrenceOffsets[var - 1];
+
+    occurrenceConstraints.resize(termLiterals.size());
+    occurrenceCoefficients.resize(termLiterals.size());
+    occurrencePositive.resize(termLiterals.size());
+    vector<Int> positions(occurrenceOffsets.begin(), occurrenceOffsets.end() - 1);
+    Int maxOccurrenceCount = 0;
+    for (Int consIndex = 0; consIndex < getConstraintCount(); consIndex++) {
+        for (Int term = termOffsets[consIndex]; term < termOffsets[consIndex + 1]; term++) {
+            Int var = std::abs(termLiterals[term]);
+            Int position = positions[var]++;
+            if (position > occurrenceOffsets[var] && occurrenceConstraints[position - 1] == consIndex) {
+                showError("Propagator needs each var at most once per constraint");
+            }
+            occurrenceConstraints[position] = consIndex;
+            occurrenceCoefficients[position] = termCoefficients[term];
+            occurrencePositive[position] = termLiterals[term] > 0;
+            maxOccurrenceCount = std::max(maxOccurrenceCount, positions[var] - occurrenceOffsets[var]);
+        }
+    }
+
+    values.assign(varCount + 1, 0);
+    trail.clear();
+    propagatedCount = 0;
+    candidates.resize(maxOccurrenceCount);
+}
+
+Int Propagator::getValue(Int lit) const {
+    Int var = std::abs(lit);
+    if (var > varCount) return 0;
+    return lit > 0 ? values[var] : -values[var];
+}
+
+// the literal of an occurrence that agrees with the assignment became true and uses up upper slack; the other one
+// became false and uses up lower slack
+void Propagator::updateSlacks(Int var, bool positive, Int sign) {
+    for (Int i = occurrenceOffsets[var]; i < occurrenceOffsets[var + 1]; i++) {
+        vector<Int>& slacks = occurrencePositive[i] == positive ? upperSlacks : lowerSlacks;
+        slacks[occurrenceConstraints[i]] -= sign * occurrenceCoefficients[i];
+    }
+}
+
+bool Propagator::hasConflict(Int var) const {
+    bool conflict = false;
+    for (Int i = occurrenceOffsets[var]; i < occurrenceOffsets[var + 1]; i++) {  // no early exit, so no branch
+        Int consIndex = occurrenceConstraints[i];
+        conflict |= activeFlags[consIndex] & ((upperSlacks[consIndex] < 0) | (lowerSlacks[consIndex] < 0));
+    }
+    return conflict;
+}
+
+// a constraint can force a term only if one of its slacks is below its max coef
+Int Propagator::findCandidates(Int var) {
+    Int candidateCount = 0;
+    for (Int i = occurrenceOffsets[var]; i < occurrenceOffsets[var + 1]; i++) {
+        Int consIndex = occurrenceConstraints[i];
+        Int maxCoefficient = maxCoefficients[consIndex];
+        candidates[candidateCount] = consIndex;  // kept only if counted
+        candidateCount += activeFlags[consIndex] & ((upperSlacks[consIndex] < maxCoefficient) | (lowerSlacks[consIndex] < maxCoefficient));
+    }
+    return candidateCount;
+}
+
+bool Propagator::assign(Int lit) {
+    Int var = std::abs(lit);
+    if (var > varCount) showError("Propagator has no var " + to_string(var));
+    if (values[var] != 0) return getValue(lit) > 0;
+
+    values[var] = lit > 0 ? 1 : -1;
+    trail.push_back(lit);
+    updateSlacks(var, lit > 0, 1);
+    return !hasConflict(var);
+}
+
+// an unassigned literal with coef c is implied false if c > upperSlack, true if c > lowerSlack
+bool Propagator::propagateConstraint(Int consIndex) {
+    for (Int term = termOffsets[consIndex]; term < termOffsets[consIndex + 1]; term++) {
+        Int lit = termLiterals[term];
+        if (getValue(lit) != 0) continue;
+        Int coef = termCoefficients[term];
+        if (coef > upperSlacks[consIndex]) {
+            if (!assign(-lit)) return false;
+        } else if (coef > lowerSlacks[consIndex]) {
+            if (!assign(lit)) return false;
+        }
+    }
+    return true;
+}
+
+// candidates are filtered before any of them assigns; a constraint whose slacks change afterwards
+// contains the newly assigned var, so it is filtered again when that var is reached on the trail
+bool Propagator::propagate() {
+    while (propagatedCount < trail.size()) {
+        Int var = std::abs(trail[propagatedCount++]);
+        Int candidateCount = findCandidates(var);
+        for (Int i = 0; i < candidateCount; i++) {
+            if (!propagateConstraint(candidates[i])) return false;
+        }
+    }
+    return true;
+}
+
+void Propagator::backtrack(Int trailSize) {
+    while (trail.size() > trailSize) {
+        Int lit = trail.back();
+        trail.pop_back();
+        Int var = std::abs(lit);
+        updateSlacks(var, lit > 0, -1);
+        values[var] = 0;
+    }
+    propagatedCount = std::min(propagatedCount, trailSize);
+}
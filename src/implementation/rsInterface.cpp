@@ -1,3 +1,10 @@
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+
+#include <atomic>
+#include <csignal>
+
 #include "../interface/rsInterface.hpp"
 
 namespace rs {
@@ -9,164 +16,227 @@ Stats stats;
 
 namespace rsSolver {
 
-extern string getVarState(VarState varState) {
-    switch(varState) {
-        case VarState::UNKNOWN: return "UNKNOWN";
-        case VarState::_TRUE:   return "_TRUE";
-        case VarState::_FALSE:  return "_FALSE";
-        case VarState::TRUE:    return "TRUE";
-        case VarState::FALSE:   return "FALSE";
-        case VarState::UNCERTAIN:   return "UNCERTAIN";
-    }
-    return "NONE";
-}
-
-extern Int judgeVarStates(const vector<VarState> &varStates) {
-    for(Int i = 1; i < varStates.size(); i++) {
-        if(varStates.at(i) == VarState::_TRUE) return i;
-        else if(varStates.at(i) == VarState::_FALSE) return -i;
-    }
-    return 0;
-}
+/* class IncrementalSolver ****************************************************/
 
-extern void updateVarStates(vector<VarState> &varStates, const vector<int> &curModel) {
-    assert(varStates.size() == curModel.size());
-    for(Int i = 1; i < varStates.size(); i++) {
-        if(curModel.at(i) > 0) {
-            if(varStates.at(i) == VarState::UNKNOWN) varStates.at(i) = VarState::_TRUE;
-            else if(varStates.at(i) == VarState::_FALSE) varStates.at(i) = VarState::UNCERTAIN;
-            else if(varStates.at(i) == VarState::FALSE)  showError("Conflict in updateVarStates");
-        } else if(curModel.at(i) < 0) {
-            if(varStates.at(i) == VarState::UNKNOWN) varStates.at(i) = VarState::_FALSE;
-            else if(varStates.at(i) == VarState::_TRUE) varStates.at(i) = VarState::UNCERTAIN;
-            else if(varStates.at(i) == VarState::TRUE)  showError("Conflict in updateVarStates");
-        }
-        // cout << i << ": " << getVarState(varStates.at(i)) << "  " << curModel.at(i) << std::endl;
+bool IncrementalSolver::addConstraint(const rs::CeArb& input) {
+    if (consistent && solver.addConstraint(input, rs::Origin::FORMULA).second == rs::ID_Unsat) {
+        consistent = false;
     }
+    return consistent;
 }
 
-extern bool tryBackBoneSolve(const Pbf &pbf, const vector<Int> &backBone, const Int lit, vector<int> &curModel) {
-    rs::Solver solver;
+IncrementalSolver::IncrementalSolver(const Pbf &pbf) {
     solver.init();                                  // call after having read options
+    varCount = std::max(pbf.getApparentVarCount(), Int(0));  // DUMMY_MIN_INT without constraints
+    if (varCount > 0) solver.setNbVars(varCount, true);
 
     rs::CeArb input = solver.cePools.takeArb();
-    // rs::CeArb objective = solver.cePools.takeArb();
-    const vector<vector<Int> > &clasues = pbf.getClauses();
-    const vector<vector<Int> > &coefs   = pbf.getCoefficients();
-    const vector<string> &options = pbf.getOptions();
-    const vector<Int>    &limits  = pbf.getLimits();
+    const PbConstraintStore &constraints = pbf.getConstraints();
 
     // in pbf is <= K, but roundingsat need >= K 
-    for(Int i = 0; i < clasues.size(); i++) {
+    for(Int i = 0; i < constraints.size(); i++) {
+        Span<Int> clause = constraints.getLiterals(i);
+        Span<Int> coefs  = constraints.getCoefficients(i);
         input->reset();
-        for(Int j = 0; j < clasues.at(i).size(); j++) {
-            solver.setNbVars(std::abs(clasues.at(i).at(j)), true);
-            input->addLhs(-coefs.at(i).at(j), clasues.at(i).at(j));
-        }
-        input->addRhs(-limits.at(i));
-        
-        if (solver.addConstraint(input, rs::Origin::FORMULA).second == rs::ID_Unsat) {
-            return false;
+        for(Int j = 0; j < clause.size(); j++) {
+            input->addLhs(-coefs[j], clause[j]);
         }
+        input->addRhs(-constraints.getLimit(i));
+        if (!addConstraint(input)) return;
 
-        if(options.at(i) == EQUAL_WORD) {
+        if(constraints.getRelation(i) == PbRelation::EQUAL) {
             input->invert();
-            if (solver.addConstraint(input, rs::Origin::FORMULA).second == rs::ID_Unsat) {
-                return false;
-            }
+            if (!addConstraint(input)) return;
         }
     }
+}
 
-    // 1 * BackBone.at(i) = 1
-    for(Int i = 0; i < backBone.size(); i++) {
-        input->reset();
-        solver.setNbVars(std::abs(backBone.at(i)), true);
-        input->addLhs(1, backBone.at(i));
-        input->addRhs(1);
-        if (solver.addConstraint(input, rs::Origin::FORMULA).second == rs::ID_Unsat) {
-            return false;
-        }
-        input->invert();
-        if (solver.addConstraint(input, rs::Origin::FORMULA).second == rs::ID_Unsat) {
-            return false;
-        }
-    }
+bool IncrementalSolver::addUnit(Int lit) {
+    rs::CeArb input = solver.cePools.takeArb();
+    input->addLhs(1, lit);
+    input->addRhs(1);
+    return addConstraint(input);
+}
+
+bool IncrementalSolver::solve(const vector<Int> &assumptions, vector<int> &curModel) {
+    if (!consistent) return false;
+
+    rs::IntSet assumptionSet(varCount + 1);
+    for (Int lit : assumptions) assumptionSet.add(lit);
+    solver.setAssumptions(assumptionSet);
 
-    // 1 * lit = 1
-    if (lit != 0) {
-        input->reset();
-        solver.setNbVars(std::abs(lit), true);
-        input->addLhs(1, lit);
-        input->addRhs(1);
-        if (solver.addConstraint(input, rs::Origin::FORMULA).second == rs::ID_Unsat) {
-            return false;
-        }
-        input->invert();
-        if (solver.addConstraint(input, rs::Origin::FORMULA).second == rs::ID_Unsat) {
-            return false;
-        }
-    }
-    
     while (true) {
         rs::SolveState reply = rs::aux::timeCall<rs::SolveState>([&] { return solver.solve().state; }, rs::stats.SOLVETIME);
-        // assert(reply != SolveState::INCONSISTENT);
         if (reply == rs::SolveState::SAT) {
-            // cout << "SAT\n";
             curModel = solver.lastSol;
-            // rs::quit::printSol(solver.lastSol);
             return true;
         } else if (reply == rs::SolveState::UNSAT) {
-            // cout << "UNSAT\n";
+            consistent = false;
+            return false;
+        } else if (reply == rs::SolveState::INCONSISTENT) {  // unsatisfiable under assumptions only
             return false;
         }
-    } 
+    }
 }
 
-extern bool getBackBone(const Pbf &pbf, vector<Int> &backBone) {
-    char *op[] = {"options", "--verbosity=0"};
-    rs::options.parseCommandLine(2, op);
+/* backbone *******************************************************************/
+
+static_assert(std::atomic<Int>::is_always_lock_free, "backbone workers share atomics across processes");
+
+// candidate states: +-1 = the literal +-var holds in every model so far, +-2 = +-var is backbone, 0 = neither
+// everything lives in anonymous shared memory, so forked workers see each other's models and backbone literals
+struct BackboneState {
+    Int varCount;
+    std::atomic<Int>* nextVar;  // next var to be tested by any worker
+    std::atomic<Int>* states;   // var |-> candidate state
+    std::atomic<Int>* log;      // backbone literals in discovery order, 0 where not yet written
+    std::atomic<Int>* logSize;
+    std::atomic<Int>* satisfiable;  // 1 or -1 once the formula is solved without assumptions, 0 before
+
+    BackboneState(Int varCount);
+    ~BackboneState();
+};
+
+template <typename T>
+static T* mapShared(Int count) {
+    void* memory = mmap(nullptr, count * sizeof(T), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) showError("unable to map shared memory for backbone workers");
+    T* elements = static_cast<T*>(memory);
+    for (Int i = 0; i < count; i++) new (elements + i) T(0);
+    return elements;
+}
 
+BackboneState::BackboneState(Int varCount) : varCount(varCount) {
+    nextVar = mapShared<std::atomic<Int>>(1);
+    states = mapShared<std::atomic<Int>>(varCount + 1);
+    log = mapShared<std::atomic<Int>>(varCount + 1);
+    logSize = mapShared<std::atomic<Int>>(1);
+    satisfiable = mapShared<std::atomic<Int>>(1);
+    nextVar->store(1);
+}
+
+BackboneState::~BackboneState() {
+    munmap(nextVar, sizeof(std::atomic<Int>));
+    munmap(states, (varCount + 1) * sizeof(std::atomic<Int>));
+    munmap(log, (varCount + 1) * sizeof(std::atomic<Int>));
+    munmap(logSize, sizeof(std::atomic<Int>));
+    munmap(satisfiable, sizeof(std::atomic<Int>));
+}
+
+// rules out every candidate that curModel falsifies
+static void filterCandidates(BackboneState& state, const vector<int>& curModel) {
+    for (Int var = 1; var <= state.varCount; var++) {
+        Int candidate = state.states[var].load();
+        if (std::abs(candidate) != 1) continue;
+        Int value = var < curModel.size() && curModel[var] > 0 ? 1 : -1;
+        if (candidate != value) state.states[var].compare_exchange_strong(candidate, 0);
+    }
+}
+
+// takes vars from state.nextVar until none is left or timeLimit (seconds, 0: none) has passed since startPoint
+static void searchBackbone(IncrementalSolver& solver, BackboneState& state, TimePoint startPoint, Float timeLimit) {
+    Int logPosition = 0;  // backbone literals already added to solver, this worker's own included
     vector<int> curModel;
-    vector<VarState> varStates;
-    Int varCnt = pbf.getApparentVarCount();
+    while (timeLimit <= 0 || util::getSeconds(startPoint) < timeLimit) {
+        Int var = state.nextVar->fetch_add(1);
+        if (var > state.varCount) break;
 
-    varStates.resize(varCnt + 1, VarState::UNKNOWN);
-    backBone.clear();
+        for (Int lit; logPosition < state.logSize->load() && (lit = state.log[logPosition].load()) != 0; logPosition++) {
+            solver.addUnit(lit);
+        }
 
-    if(tryBackBoneSolve(pbf, backBone, 0, curModel)) {
-        updateVarStates(varStates, curModel);
-    } else return false;
+        Int candidate = state.states[var].load();
+        if (std::abs(candidate) != 1) continue;
+        Int lit = candidate * var;
 
-    Int lit;
-    while((lit = judgeVarStates(varStates)) != 0) {
-        // cout << std::endl << std::endl << "GetLit = " << lit << std::endl;
-        if(tryBackBoneSolve(pbf, backBone, -lit, curModel)) {
-            if(varStates.at(std::abs(lit)) == VarState::UNKNOWN) {
-                varStates.at(std::abs(lit)) = lit > 0 ? VarState::_FALSE : VarState::_TRUE;
-            } else varStates.at(std::abs(lit)) = VarState::UNCERTAIN;
+        if (solver.solve({-lit}, curModel)) {
+            filterCandidates(state, curModel);
+        } else if (state.states[var].compare_exchange_strong(candidate, 2 * candidate)) {
+            state.log[state.logSize->fetch_add(1)].store(lit);  // added to solver from the log, before the next candidate
+        }
+    }
+}
 
-            updateVarStates(varStates, curModel);
+// forks workerCount children running work, and kills those still running once timeLimit (seconds, 0: none) has passed
+// since startPoint; false if no child could be forked
+template <typename Work>
+static bool runWorkers(Int workerCount, Work work, TimePoint startPoint, Float timeLimit) {
+    cout << std::flush;  // children must not repeat buffered output
+    vector<pid_t> workers;
+    for (Int i = 0; i < workerCount; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {  // each child continues from its copy of the loaded solver
+            prctl(PR_SET_PDEATHSIG, SIGKILL);  // no orphan keeps solving after a timeout
+            signal(SIGINT, SIG_DFL);
+            signal(SIGTERM, SIG_DFL);
+            work();
+            _exit(0);
+        } else if (pid > 0) {
+            workers.push_back(pid);
         } else {
-            if(varStates.at(std::abs(lit)) == VarState::UNKNOWN) {
-                varStates.at(std::abs(lit)) = lit > 0 ? VarState::_TRUE : VarState::_FALSE;
-            } else if(varStates.at(std::abs(lit)) == VarState::_FALSE) {
-                assert(lit < 0);
-                varStates.at(std::abs(lit)) = VarState::FALSE;
-                backBone.push_back(lit);
-            } else if(varStates.at(std::abs(lit)) == VarState::_TRUE) {
-                assert(lit > 0);
-                varStates.at(std::abs(lit)) = VarState::TRUE;
-                backBone.push_back(lit);
-            }
+            showWarning("unable to fork backbone worker " + to_string(i));
         }
-        // cout << "BackBone size: " << backBone.size() << std::endl;
-        // for(auto p : backBone) cout << p << " ";
-        // cout << std::endl;
     }
-    // trySolve(pbf, backBone, curModel);
-    return true;    
+    if (workers.empty()) return false;
+
+    while (!workers.empty()) {  // a worker may be inside a long solve when the time limit passes
+        for (Int i = workers.size() - 1; i >= 0; i--) {
+            if (waitpid(workers[i], nullptr, WNOHANG) == workers[i]) workers.erase(workers.begin() + i);
+        }
+        if (!workers.empty() && timeLimit > 0 && util::getSeconds(startPoint) >= timeLimit) {
+            for (pid_t pid : workers) kill(pid, SIGKILL);
+            for (pid_t pid : workers) waitpid(pid, nullptr, 0);
+            workers.clear();
+        }
+        if (!workers.empty()) usleep(1000);
+    }
+    return true;
 }
 
+// every literal true in all models, found by backboneWorkerCount processes within timeLimit (seconds, 0: none)
+// RoundingSat keeps its options and stats process-global, so workers are forked rather than threaded
+// a RoundingSat solve has no deadline of its own, so under a time limit even the first solve runs in a killable child;
+// a var left untested when the limit passes is simply not in backBone
+extern bool getBackBone(const Pbf &pbf, vector<Int> &backBone, Float timeLimit) {
+    char *op[] = {"options", "--verbosity=0"};
+    rs::options.parseCommandLine(2, op);
+
+    TimePoint backboneStartTime = util::getTimePoint();
+    backBone.clear();
+    IncrementalSolver solver(pbf);
+
+    Int varCnt = std::max(pbf.getApparentVarCount(), Int(0));
+    BackboneState state(varCnt);
+    auto solveFormula = [&]() {  // the model seeds the candidates
+        vector<int> curModel;
+        if (!solver.solve({}, curModel)) {
+            state.satisfiable->store(-1);
+            return;
+        }
+        for (Int var = 1; var <= varCnt && var < curModel.size(); var++) {
+            state.states[var].store(curModel[var] > 0 ? 1 : -1);
+        }
+        state.satisfiable->store(1);
+    };
+    auto search = [&]() { searchBackbone(solver, state, backboneStartTime, timeLimit); };
 
-} 
+    if (timeLimit <= 0 || !runWorkers(1, solveFormula, backboneStartTime, timeLimit)) solveFormula();
+    if (state.satisfiable->load() < 0) return false;
 
+    if (state.satisfiable->load() > 0) {  // else the time limit passed first, leaving every var untested
+        if ((backboneWorkerCount <= 1 && timeLimit <= 0) || !runWorkers(backboneWorkerCount, search, backboneStartTime, timeLimit)) search();
+    }
+
+    Int untestedVarCount = 0;  // still candidates: a finished test turns a candidate into 0 or a backbone literal
+    for (Int var = 1; var <= varCnt; var++) {
+        Int candidate = state.states[var].load();
+        if (std::abs(candidate) == 2) backBone.push_back(candidate / 2 * var);
+        untestedVarCount += std::abs(candidate) == 1;
+    }
+    if (verbosityLevel >= 1) {
+        util::printRow("backboneUntestedVars", state.satisfiable->load() == 0 ? varCnt : untestedVarCount);
+    }
+    return true;    
+}
+
+}
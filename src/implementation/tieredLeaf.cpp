@@ -0,0 +1,282 @@
+/* inclusions *****************************************************************/
+
+#include <cstring>
+
+#include "../interface/tieredLeaf.hpp"
+
+/* uses ***********************************************************************/
+
+using sylvan::MTBDD;
+
+/* tiers **********************************************************************/
+
+using Wide = __int128;
+using UnsignedWide = unsigned __int128;
+
+const Int INLINE_BITS = 63;  // the low bit of the leaf word marks an inline value
+const Int WIDE_BITS = 127;   // magnitudes below 2^127, so -2^127 is promoted too
+
+enum class Tier : uint8_t { WIDE, INTEGER, QUOTIENT };
+
+// heap value of a leaf that is not inline; only the member of its tier is initialized
+struct TieredValue {
+    Tier tier;
+    Wide wide;
+    mpz_t integer;
+    mpq_t quotient;
+};
+
+static bool isInline(uint64_t value) {
+    return value & 1;
+}
+
+static const TieredValue* getTieredValue(uint64_t value) {
+    return reinterpret_cast<const TieredValue*>(value);
+}
+
+static bool isIntegral(uint64_t value) {
+    return isInline(value) || getTieredValue(value)->tier != Tier::QUOTIENT;
+}
+
+static bool isWide(uint64_t value) {
+    return isInline(value) || getTieredValue(value)->tier == Tier::WIDE;
+}
+
+static Wide getWide(uint64_t value) {  // for isWide values
+    if (isInline(value)) return Wide(int64_t(value) >> 1);  // arithmetic shift restores the sign
+    return getTieredValue(value)->wide;
+}
+
+static void setInteger(mpz_ptr z, Wide w) {
+    UnsignedWide magnitude = w < 0 ? -UnsignedWide(w) : UnsignedWide(w);
+    uint64_t limbs[2] = {uint64_t(magnitude), uint64_t(magnitude >> 64)};
+    mpz_import(z, 2, -1, sizeof(uint64_t), 0, 0, limbs);
+    if (w < 0) mpz_neg(z, z);
+}
+
+static Wide getWide(mpz_srcptr z) {  // for |z| < 2^127
+    uint64_t limbs[2] = {0, 0};
+    mpz_export(limbs, nullptr, -1, sizeof(uint64_t), 0, 0, z);
+    Wide magnitude = Wide((UnsignedWide(limbs[1]) << 64) | limbs[0]);
+    return mpz_sgn(z) < 0 ? -magnitude : magnitude;
+}
+
+static mpz_class getInteger(uint64_t value) {  // for isIntegral values
+    mpz_class z;
+    if (isWide(value)) {
+        setInteger(z.get_mpz_t(), getWide(value));
+    } else {
+        z = mpz_class(getTieredValue(value)->integer);
+    }
+    return z;
+}
+
+static mpq_class getQuotient(uint64_t value) {
+    if (isIntegral(value)) return mpq_class(getInteger(value));
+    return mpq_class(getTieredValue(value)->quotient);
+}
+
+/* Sylvan leaf callbacks ******************************************************/
+
+static uint64_t mix(uint64_t hash, uint64_t word) {
+    hash = (hash ^ word) * 0x100000001b3ULL;
+    return hash ^ (hash >> 29);
+}
+
+static uint64_t hashInteger(uint64_t hash, mpz_srcptr z) {
+    hash = mix(hash, mpz_sgn(z));
+    for (size_t i = 0; i < mpz_size(z); i++) hash = mix(hash, mpz_getlimbn(z, i));
+    return hash;
+}
+
+static uint64_t hashLeaf(uint64_t value, uint64_t seed) {
+    uint64_t hash = mix(seed, 0xcbf29ce484222325ULL);
+    if (isInline(value)) return mix(hash, value);
+    const TieredValue* v = getTieredValue(value);
+    switch (v->tier) {
+        case Tier::WIDE:
+            return mix(mix(hash, uint64_t(v->wide)), uint64_t(UnsignedWide(v->wide) >> 64));
+        case Tier::INTEGER:
+            return hashInteger(hash, v->integer);
+        default:
+            return hashInteger(hashInteger(hash, mpq_numref(v->quotient)), mpq_denref(v->quotient));
+    }
+}
+
+static int equalLeaves(uint64_t left, uint64_t right) {
+    if (isInline(left) || isInline(right)) return left == right;
+    const TieredValue* l = getTieredValue(left);
+    const TieredValue* r = getTieredValue(right);
+    if (l->tier != r->tier) return false;  // tiers are canonical
+    switch (l->tier) {
+        case Tier::WIDE:
+            return l->wide == r->wide;
+        case Tier::INTEGER:
+            return mpz_cmp(l->integer, r->integer) == 0;
+        default:
+            return mpq_equal(l->quotient, r->quotient);
+    }
+}
+
+// Sylvan passes the caller's temporary value, to be replaced by a copy the leaf owns
+static void createLeaf(uint64_t* value) {
+    if (isInline(*value)) return;
+    const TieredValue* source = getTieredValue(*value);
+    TieredValue* copy = new TieredValue;
+    copy->tier = source->tier;
+    switch (source->tier) {
+        case Tier::WIDE:
+            copy->wide = source->wide;
+            break;
+        case Tier::INTEGER:
+            mpz_init_set(copy->integer, source->integer);
+            break;
+        default:
+            mpq_init(copy->quotient);
+            mpq_set(copy->quotient, source->quotient);
+    }
+    *value = reinterpret_cast<uint64_t>(copy);
+}
+
+static void destroyLeaf(uint64_t value) {
+    if (isInline(value)) return;
+    TieredValue* v = reinterpret_cast<TieredValue*>(value);
+    if (v->tier == Tier::INTEGER) mpz_clear(v->integer);
+    if (v->tier == Tier::QUOTIENT) mpq_clear(v->quotient);
+    delete v;
+}
+
+static char* leafToString(int complemented, uint64_t value, char* buf, size_t bufsize) {
+    string s = getQuotient(value).get_str();
+    if (s.size() < bufsize) {
+        memcpy(buf, s.c_str(), s.size() + 1);
+        return buf;
+    }
+    return strdup(s.c_str());
+}
+
+/* leaves *********************************************************************/
+
+static uint32_t tieredLeafType;
+
+static MTBDD makeMpzLeaf(mpz_srcptr z) {  // for |z| >= 2^127
+    TieredValue v;
+    v.tier = Tier::INTEGER;
+    mpz_init_set(v.integer, z);
+    MTBDD leaf = sylvan::mtbdd_makeleaf(tieredLeafType, reinterpret_cast<uint64_t>(&v));
+    mpz_clear(v.integer);
+    return leaf;
+}
+
+static MTBDD makeWideLeaf(Wide w) {
+    const Wide inlineBound = Wide(1) << (INLINE_BITS - 1);
+    if (-inlineBound <= w && w < inlineBound) {
+        return sylvan::mtbdd_makeleaf(tieredLeafType, (uint64_t(int64_t(w)) << 1) | 1);
+    }
+    if (UnsignedWide(w) == UnsignedWide(1) << WIDE_BITS) {  // -2^127
+        mpz_class z;
+        setInteger(z.get_mpz_t(), w);
+        return makeMpzLeaf(z.get_mpz_t());
+    }
+    TieredValue v;
+    v.tier = Tier::WIDE;
+    v.wide = w;
+    return sylvan::mtbdd_makeleaf(tieredLeafType, reinterpret_cast<uint64_t>(&v));
+}
+
+static MTBDD makeIntegerLeaf(const mpz_class& z) {
+    if (mpz_sizeinbase(z.get_mpz_t(), 2) <= WIDE_BITS) return makeWideLeaf(getWide(z.get_mpz_t()));
+    return makeMpzLeaf(z.get_mpz_t());
+}
+
+static MTBDD makeQuotientLeaf(const mpq_class& q) {  // q is canonical
+    if (q.get_den() == 1) return makeIntegerLeaf(q.get_num());
+    TieredValue v;
+    v.tier = Tier::QUOTIENT;
+    mpq_init(v.quotient);
+    mpq_set(v.quotient, q.get_mpq_t());
+    MTBDD leaf = sylvan::mtbdd_makeleaf(tieredLeafType, reinterpret_cast<uint64_t>(&v));
+    mpq_clear(v.quotient);
+    return leaf;
+}
+
+/* class TieredLeaf ***********************************************************/
+
+bool TieredLeaf::active = false;
+
+void TieredLeaf::initLeafType() {
+    tieredLeafType = sylvan::sylvan_mt_create_type();
+    sylvan::sylvan_mt_set_hash(tieredLeafType, hashLeaf);
+    sylvan::sylvan_mt_set_equals(tieredLeafType, equalLeaves);
+    sylvan::sylvan_mt_set_create(tieredLeafType, createLeaf);
+    sylvan::sylvan_mt_set_destroy(tieredLeafType, destroyLeaf);
+    sylvan::sylvan_mt_set_to_str(tieredLeafType, leafToString);
+    active = true;
+}
+
+MTBDD TieredLeaf::getLeaf(const mpq_class& q) {
+    return makeQuotientLeaf(q);
+}
+
+mpq_class TieredLeaf::getQuotient(MTBDD leaf) {
+    if (leaf == sylvan::mtbdd_false) return mpq_class(0);
+    return ::getQuotient(sylvan::mtbdd_getvalue(leaf));
+}
+
+/* Lace tasks *****************************************************************/
+
+// mtbdd_false is zero; operands are swapped into a canonical order for the operation cache
+TASK_IMPL_2(MTBDD, tiered_op_times, MTBDD*, pa, MTBDD*, pb) {
+    MTBDD a = *pa, b = *pb;
+    if (a == sylvan::mtbdd_false || b == sylvan::mtbdd_false) return sylvan::mtbdd_false;
+    if (sylvan::mtbdd_isleaf(a) && sylvan::mtbdd_isleaf(b)) {
+        uint64_t left = sylvan::mtbdd_getvalue(a), right = sylvan::mtbdd_getvalue(b);
+        Wide product;
+        if (isWide(left) && isWide(right) && !__builtin_mul_overflow(getWide(left), getWide(right), &product)) {
+            return makeWideLeaf(product);
+        }
+        if (isIntegral(left) && isIntegral(right)) return makeIntegerLeaf(getInteger(left) * getInteger(right));
+        return makeQuotientLeaf(getQuotient(left) * getQuotient(right));
+    }
+    if (a > b) {
+        *pa = b;
+        *pb = a;
+    }
+    return sylvan::mtbdd_invalid;
+}
+
+TASK_IMPL_2(MTBDD, tiered_op_plus, MTBDD*, pa, MTBDD*, pb) {
+    MTBDD a = *pa, b = *pb;
+    if (a == sylvan::mtbdd_false) return b;
+    if (b == sylvan::mtbdd_false) return a;
+    if (sylvan::mtbdd_isleaf(a) && sylvan::mtbdd_isleaf(b)) {
+        uint64_t left = sylvan::mtbdd_getvalue(a), right = sylvan::mtbdd_getvalue(b);
+        Wide sum;
+        if (isWide(left) && isWide(right) && !__builtin_add_overflow(getWide(left), getWide(right), &sum)) {
+            return makeWideLeaf(sum);
+        }
+        if (isIntegral(left) && isIntegral(right)) return makeIntegerLeaf(getInteger(left) + getInteger(right));
+        return makeQuotientLeaf(getQuotient(left) + getQuotient(right));
+    }
+    if (a > b) {
+        *pa = b;
+        *pb = a;
+    }
+    return sylvan::mtbdd_invalid;
+}
+
+TASK_IMPL_2(MTBDD, tiered_op_max, MTBDD*, pa, MTBDD*, pb) {
+    MTBDD a = *pa, b = *pb;
+    if (a == b || b == sylvan::mtbdd_false) return a;
+    if (a == sylvan::mtbdd_false) return b;
+    if (sylvan::mtbdd_isleaf(a) && sylvan::mtbdd_isleaf(b)) {
+        uint64_t left = sylvan::mtbdd_getvalue(a), right = sylvan::mtbdd_getvalue(b);
+        if (isWide(left) && isWide(right)) return getWide(left) >= getWide(right) ? a : b;
+        return getQuotient(left) >= getQuotient(right) ? a : b;
+    }
+    if (a > b) {
+        *pa = b;
+        *pb = a;
+    }
+    return sylvan::mtbdd_invalid;
+}
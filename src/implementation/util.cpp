@@ -37,6 +37,19 @@ const string& DIAGRAM_PACKAGE_OPTION = "dp";
 const string& MULTIPLE_PRECISION_OPTION = "mp";
 const string& MAXIMUM_MEMORY_OPTION = "mm";
 const string& PREPROCESSOR_OPTION = "pr";
+const string& BACKBONE_WORKER_OPTION = "bw";
+const string& BACKBONE_TIME_OPTION = "bt";
+const string& THREAD_COUNT_OPTION = "tc";
+const string& PRODUCT_SCHEDULING_OPTION = "ps";
+const string& CACHE_FILE_OPTION = "cf";
+const string& PREPROCESS_PASS_OPTION = "pp";
+const string& VIVIFY_LITERAL_OPTION = "ve";
+const string& COMPONENT_WORKER_OPTION = "cw";
+const string& MODULAR_COUNTING_OPTION = "mc";
+const string& LOG_COUNTING_OPTION = "lc";
+const string& TIERED_LEAF_OPTION = "tl";
+const string& COMPILE_FILE_OPTION = "co";
+const string& EVALUATE_FILE_OPTION = "ev";
 
 const string& CUDD_PACKAGE = "c";
 const string& SYLVAN_PACKAGE = "s";
@@ -45,6 +58,15 @@ const string DEFAULT_DIAGRAM_PACKAGE = "s";
 const Int DEFAULT_MULTIPLE_PRECISION = 1;
 const Int DEFAULT_MAXIMUM_MEMORY = 16000;
 const Int DEFAULT_PREPROCESSOR = 0;
+const Int DEFAULT_BACKBONE_WORKER_COUNT = 1;
+const Float DEFAULT_BACKBONE_TIME_LIMIT = 0;
+const Int DEFAULT_THREAD_COUNT = 1;
+const string DEFAULT_PREPROCESS_PASSES = "backbone,vivify";  // probe is opt-in through --pp until validated against unpreprocessed counts
+const Int DEFAULT_VIVIFY_LITERAL_LIMIT = 20;
+const Int DEFAULT_COMPONENT_WORKER_COUNT = 1;
+const Int DEFAULT_MODULAR_COUNTING = 0;
+const Int DEFAULT_LOG_COUNTING = 0;
+const Int DEFAULT_TIERED_LEAVES = 0;  // opt-in until checked against gmp leaves
 
 /* global variables ***********************************************************/
 
@@ -59,6 +81,18 @@ Int maxMem = DEFAULT_MAXIMUM_MEMORY;
 Float tableRatio = 1;
 Float initRatio = 10;
 bool preprocessorFlag = DEFAULT_PREPROCESSOR;
+Int backboneWorkerCount = DEFAULT_BACKBONE_WORKER_COUNT;
+Float backboneTimeLimit = DEFAULT_BACKBONE_TIME_LIMIT;
+Int threadCount = DEFAULT_THREAD_COUNT;
+string cacheFilePath;
+string preprocessPasses = DEFAULT_PREPROCESS_PASSES;
+Int vivifyLiteralLimit = DEFAULT_VIVIFY_LITERAL_LIMIT;
+Int componentWorkerCount = DEFAULT_COMPONENT_WORKER_COUNT;
+bool modularCounting = DEFAULT_MODULAR_COUNTING;
+bool logCounting = DEFAULT_LOG_COUNTING;
+bool tieredLeaves = DEFAULT_TIERED_LEAVES;
+string compileFilePath;
+string evaluateFilePath;
 
 const std::map<Int, WeightFormat> WEIGHT_FORMAT_CHOICES = {
     {1, WeightFormat::UNWEIGHTED},
@@ -74,13 +108,22 @@ const std::map<Int, ClusteringHeuristic> CLUSTERING_HEURISTIC_CHOICES = {
     {6, ClusteringHeuristic::BOUQUET_TREE}};
 const Int DEFAULT_CLUSTERING_HEURISTIC_CHOICE = 6;
 
+const std::map<Int, ProductScheduling> PRODUCT_SCHEDULING_CHOICES = {
+    {1, ProductScheduling::CONSTRAINT_ORDER},
+    {2, ProductScheduling::SMALLEST_FIRST}};
+const Int DEFAULT_PRODUCT_SCHEDULING_CHOICE = 1;
+ProductScheduling productScheduling = PRODUCT_SCHEDULING_CHOICES.at(DEFAULT_PRODUCT_SCHEDULING_CHOICE);
+
 const std::map<Int, VarOrderingHeuristic> VAR_ORDERING_HEURISTIC_CHOICES = {
     {1, VarOrderingHeuristic::APPEARANCE},
     {2, VarOrderingHeuristic::DECLARATION},
     {3, VarOrderingHeuristic::RANDOM},
     {4, VarOrderingHeuristic::MCS},
     {5, VarOrderingHeuristic::LEXP},
-    {6, VarOrderingHeuristic::LEXM}};
+    {6, VarOrderingHeuristic::LEXM},
+    {7, VarOrderingHeuristic::MINFILL},
+    {8, VarOrderingHeuristic::MINDEGREE},
+    {9, VarOrderingHeuristic::WEIGHTED_MINFILL}};
 const Int DEFAULT_CNF_VAR_ORDERING_HEURISTIC_CHOICE = 5;
 const Int DEFAULT_DD_VAR_ORDERING_HEURISTIC_CHOICE = 4;
 
@@ -128,6 +171,13 @@ void util::printSolutionLine(Number modelCount, WeightFormat weightFormat, Int p
     // cout << "s " << " " << modelCount << "\n"
     if(multiplePrecision) {
         cout << "s  " << mpf_class(modelCount.quotient) << "\n";
+    } else if (logCounting) {  // 10^fraction may exceed a double, so mantissa and exponent are printed apart
+        if (modelCount.fraction == NEGATIVE_INFINITY) {
+            cout << "s  0\n";
+        } else {
+            Float exponent = floorl(modelCount.fraction);
+            cout << "s  " << std::defaultfloat << std::setprecision(15) << exp10l(modelCount.fraction - exponent) << "e" << Int(exponent) << "\n";
+        }
     } else {
         cout << "s  " << modelCount << "\n";
     }
@@ -254,6 +304,75 @@ void util::printPreprocessorOption() {
     cout << "Default: " + to_string(DEFAULT_PREPROCESSOR) + "\n";
 }
 
+void util::printBackboneWorkerOption() {
+    cout << "      --" << BACKBONE_WORKER_OPTION << std::left << std::setw(56) << " arg  backbone solver processes (preprocessor)";
+    cout << "Default: " + to_string(DEFAULT_BACKBONE_WORKER_COUNT) + "\n";
+}
+
+void util::printBackboneTimeOption() {
+    cout << "      --" << BACKBONE_TIME_OPTION << std::left << std::setw(56) << " arg  backbone time limit in seconds (0 for none)";
+    cout << "Default: " + to_string(Int(DEFAULT_BACKBONE_TIME_LIMIT)) + "\n";
+}
+
+void util::printPreprocessPassOption() {
+    cout << "      --" << PREPROCESS_PASS_OPTION << std::left << std::setw(56) << " arg  passes backbone/probe/vivify[:seconds], in order";
+    cout << "Default: " + DEFAULT_PREPROCESS_PASSES + "\n";
+}
+
+void util::printVivifyLiteralOption() {
+    cout << "      --" << VIVIFY_LITERAL_OPTION << std::left << std::setw(56) << " arg  vivify only constraints with fewer literals";
+    cout << "Default: " + to_string(DEFAULT_VIVIFY_LITERAL_LIMIT) + "\n";
+}
+
+void util::printThreadCountOption() {
+    cout << "      --" << THREAD_COUNT_OPTION << std::left << std::setw(56) << " arg  thread count (Sylvan Package; 0 for all cores)";
+    cout << "Default: " + to_string(DEFAULT_THREAD_COUNT) + "\n";
+}
+
+void util::printComponentWorkerOption() {
+    cout << "      --" << COMPONENT_WORKER_OPTION << std::left << std::setw(56) << " arg  component counting processes (CUDD Package)";
+    cout << "Default: " + to_string(DEFAULT_COMPONENT_WORKER_COUNT) + "\n";
+}
+
+void util::printModularCountingOption() {
+    cout << "      --" << MODULAR_COUNTING_OPTION << std::left << std::setw(56) << " arg  modular counting, needs --mp 1 (Sylvan; 0/1)";
+    cout << "Default: " + to_string(DEFAULT_MODULAR_COUNTING) + "\n";
+}
+
+void util::printLogCountingOption() {
+    cout << "      --" << LOG_COUNTING_OPTION << std::left << std::setw(56) << " arg  log10 counting, needs --mp 0 (0/1)";
+    cout << "Default: " + to_string(DEFAULT_LOG_COUNTING) + "\n";
+}
+
+void util::printTieredLeafOption() {
+    cout << "      --" << TIERED_LEAF_OPTION << std::left << std::setw(56) << " arg  int128/mpz/mpq leaves for --mp 1 (Sylvan; 0/1)";
+    cout << "Default: " + to_string(DEFAULT_TIERED_LEAVES) + "\n";
+}
+
+void util::printProductSchedulingOption() {
+    cout << "      --" << PRODUCT_SCHEDULING_OPTION << " arg  ";
+    cout << "product scheduling in clusters:\n";
+    for (const auto& kv : PRODUCT_SCHEDULING_CHOICES) {
+        int num = kv.first;
+        cout << "           " << num << "    " << std::left << std::setw(50) << getProductSchedulingName(kv.second);
+        if (num == DEFAULT_PRODUCT_SCHEDULING_CHOICE)
+            cout << "Default: " << DEFAULT_PRODUCT_SCHEDULING_CHOICE;
+        cout << "\n";
+    }
+}
+
+void util::printCacheFileOption() {
+    cout << "      --" << CACHE_FILE_OPTION << std::left << std::setw(56) << " arg  binary formula cache: read if it matches the input, else written" << std::endl;
+}
+
+void util::printCompileFileOption() {
+    cout << "      --" << COMPILE_FILE_OPTION << std::left << std::setw(56) << " arg  compiled diagram: weight-free, written instead of counting" << std::endl;
+}
+
+void util::printEvaluateFileOption() {
+    cout << "      --" << EVALUATE_FILE_OPTION << std::left << std::setw(56) << " arg  compiled diagram: counted with the weights of the input file" << std::endl;
+}
+
 /* functions: argument parsing ************************************************/
 
 vector<string> util::getArgV(int argc, char* argv[]) {
@@ -263,6 +382,10 @@ vector<string> util::getArgV(int argc, char* argv[]) {
     return argV;
 }
 
+string util::getRelationWord(PbRelation relation) {
+    return relation == PbRelation::EQUAL ? EQUAL_WORD : LEQUAL_WORD;
+}
+
 string util::getWeightFormatName(WeightFormat weightFormat) {
     switch (weightFormat) {
         case WeightFormat::UNWEIGHTED: {
@@ -306,6 +429,21 @@ string util::getClusteringHeuristicName(ClusteringHeuristic clusteringHeuristic)
     }
 }
 
+string util::getProductSchedulingName(ProductScheduling productScheduling) {
+    switch (productScheduling) {
+        case ProductScheduling::CONSTRAINT_ORDER: {
+            return "CONSTRAINT_ORDER";
+        }
+        case ProductScheduling::SMALLEST_FIRST: {
+            return "SMALLEST_FIRST";
+        }
+        default: {
+            showError("no such productScheduling");
+            return DUMMY_STR;
+        }
+    }
+}
+
 string util::getVarOrderingHeuristicName(VarOrderingHeuristic varOrderingHeuristic) {
     switch (varOrderingHeuristic) {
         case VarOrderingHeuristic::APPEARANCE: {
@@ -326,6 +464,15 @@ string util::getVarOrderingHeuristicName(VarOrderingHeuristic varOrderingHeurist
         case VarOrderingHeuristic::MCS: {
             return "MCS";
         }
+        case VarOrderingHeuristic::MINFILL: {
+            return "MINFILL";
+        }
+        case VarOrderingHeuristic::MINDEGREE: {
+            return "MINDEGREE";
+        }
+        case VarOrderingHeuristic::WEIGHTED_MINFILL: {
+            return "WEIGHTED_MINFILL";
+        }
         default: {
             showError("DUMMY_VAR_ORDERING_HEURISTIC in util::getVarOrderingHeuristicName");
             return DUMMY_STR;
@@ -366,21 +513,14 @@ Int util::getCnfVar(Int literal) {
     return std::abs(literal);
 }
 
-Set<Int> util::getClauseCnfVars(const vector<Int>& clause) {
+Set<Int> util::getClauseCnfVars(Span<Int> clause) {
     Set<Int> cnfVars;
     for (Int literal : clause)
         cnfVars.insert(getCnfVar(literal));
     return cnfVars;
 }
 
-Set<Int> util::getClusterCnfVars(const vector<Int>& cluster, const vector<vector<Int>>& clauses) {
-    Set<Int> cnfVars;
-    for (Int clauseIndex : cluster)
-        unionize(cnfVars, getClauseCnfVars(clauses.at(clauseIndex)));
-    return cnfVars;
-}
-
-bool util::appearsIn(Int cnfVar, const vector<Int>& clause) {
+bool util::appearsIn(Int cnfVar, Span<Int> clause) {
     for (Int literal : clause)
         if (getCnfVar(literal) == cnfVar)
             return true;
@@ -401,7 +541,7 @@ Int util::getLiteralRank(Int literal, const vector<Int>& cnfVarOrdering) {
     return it - cnfVarOrdering.begin();
 }
 
-Int util::getMinClauseRank(const vector<Int>& clause, const vector<Int>& cnfVarOrdering) {
+Int util::getMinClauseRank(Span<Int> clause, const vector<Int>& cnfVarOrdering) {
     Int minRank = DUMMY_MAX_INT;
     for (Int literal : clause) {
         Int rank = getLiteralRank(literal, cnfVarOrdering);
@@ -411,7 +551,7 @@ Int util::getMinClauseRank(const vector<Int>& clause, const vector<Int>& cnfVarO
     return minRank;
 }
 
-Int util::getMaxClauseRank(const vector<Int>& clause, const vector<Int>& cnfVarOrdering) {
+Int util::getMaxClauseRank(Span<Int> clause, const vector<Int>& cnfVarOrdering) {
     Int maxRank = DUMMY_MIN_INT;
     for (Int literal : clause) {
         Int rank = getLiteralRank(literal, cnfVarOrdering);
@@ -421,7 +561,7 @@ Int util::getMaxClauseRank(const vector<Int>& clause, const vector<Int>& cnfVarO
     return maxRank;
 }
 
-void util::printClause(const vector<Int>& clause) {
+void util::printClause(Span<Int> clause) {
     for (Int literal : clause) {
         cout << std::right << std::setw(5) << literal << " ";
     }
@@ -504,36 +644,14 @@ void util::inverseConstraint(vector<Int>& clause, vector<Int>& coefficient, Int&
         showError("Formula <= negative limit");
 }
 
-void util::printConstraint(const vector<Int>& clause, const vector<Int>& coefficent, const string& option, const Int& limit) {
+void util::printConstraint(Span<Int> clause, Span<Int> coefficent, PbRelation relation, Int limit) {
     for (int i = 0; i < clause.size(); i++) {
-        cout << std::right << std::setw(3) << (coefficent.at(i) > 0 ? "+" : "") << coefficent.at(i) << " x" << std::left << std::setw(5) << clause.at(i) << " ";
+        cout << std::right << std::setw(3) << (coefficent[i] > 0 ? "+" : "") << coefficent[i] << " x" << std::left << std::setw(5) << clause[i] << " ";
     }
-    cout << " " << std::right << std::setw(2) << option << " " << limit;
+    cout << " " << std::right << std::setw(2) << getRelationWord(relation) << " " << limit;
     cout << "\n";
 }
 
-void util::printPbf(const vector<vector<Int>>& clauses, const vector<vector<Int>>& coefficents, const vector<string> &options, const vector<Int>& limits) {
-    Int clausesSize = clauses.size();
-    Int coefficentsSize = coefficents.size();
-    Int limitsSize = limits.size();
-
-    if (clausesSize != coefficentsSize || clausesSize != limitsSize) {
-        showError("Unpair Constraints Size");
-    }
-
-    printThinLine();
-    printComment("pbf {");
-    for (Int i = 0; i < clauses.size(); i++) {
-        cout << COMMENT_WORD << "\t"
-                                "Constraint ";
-        cout << std::right << std::setw(5) << i + 1 << " : ";
-        printConstraint(clauses.at(i), coefficents.at(i), options.at(i), limits.at(i));
-    }
-    printComment("}");
-    printThinLine();
-
-    // std::cout << "Not implement" << std::endl;
-}
 /* functions: timing **********************************************************/
 
 TimePoint util::getTimePoint() {
@@ -0,0 +1,35 @@
+#pragma once
+
+/* inclusions *****************************************************************/
+
+#include "ddNode.hpp"
+#include "pbformula.hpp"
+
+/* classes ********************************************************************/
+
+// the conjoined 0-1 diagram of a whole formula, with no weights in it: compiled once, then counted for any literal weights
+// by one bottom-up pass, in time linear in its nodes and vars; a var skipped by an edge contributes w(x) + w(-x)
+// the preprocessor's substitutions are kept, so new weights are folded the same way as the compiled formula's
+class CompiledDiagram {
+protected:
+    vector<Int> levelVars;   // level |-> cnf var, top first; the dd var order of the compiling counter
+    vector<Int> nodeLevels;  // node id - 2 |-> level of its var; children come before parents
+    vector<Int> highIds;     // node id - 2 |-> id of its high child
+    vector<Int> lowIds;      // node id - 2 |-> id of its low child
+    Int rootId;              // ids 0 and 1 are the leaves 0 and 1
+    vector<Pair<Int, Int>> substitutions;  // (var, literal), in the order of Pbf::substituteVar
+
+    template <typename T>
+    T evaluate(const Map<Int, Number>& literalWeights, T (*getValue)(const Number&)) const;
+
+public:
+    CompiledDiagram(const Dd& dd, const vector<Int>& ddVarToCnfVarMap, const vector<Pair<Int, Int>>& substitutions, const Cudd& mgr);
+    CompiledDiagram(const string& filePath);  // reads a file written by write
+
+    Int getNodeCount() const;
+    const vector<Pair<Int, Int>>& getSubstitutions() const;
+    void write(const string& filePath) const;
+    Number evaluate(const Map<Int, Number>& literalWeights) const;  // weights after the substitutions
+
+    static void evaluateFile(const string& diagramFilePath, const string& inputFilePath, WeightFormat weightFormat);  // one solution line per lane
+};
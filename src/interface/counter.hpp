@@ -5,6 +5,8 @@
 #include "visual.hpp"
 #include "preprocess.hpp"
 #include "ddNode.hpp"
+#include "compiledDiagram.hpp"
+#include "pbDd.hpp"
 
 
 namespace diagram {
@@ -24,8 +26,10 @@ protected:
     vector<Int> ddVarToCnfVarMap;    // e.g. [42, 13], i.e. ddVarOrdering
 
     JoinNonterminal* joinRoot;
+    vector<Number> laneModelCounts;  // every lane of the last count, one per weight vector of the input
 
     static void handleSignals(int signal);  // `timeout` sends SIGTERM
+    static bool countingInParallel();       // Sylvan with more than one Lace worker
 
     void writeDotFile(Dd& dd, const string& dotFileDir = DOT_DIR);
     template <typename T>
@@ -39,32 +43,39 @@ protected:
     void orderDdVars(const Pbf& pbf);             // writes: cnfVarToDdVarMap, ddVarToCnfVarMap
     void printCnfToDdVarMap() const;
     
-    Dd getConstraintDd(const vector<Int>& clause, const vector<Int>& coefficient, const string& option, const Int& limit) const;
-    Dd constructDd(const vector<Pair<Int, Pair<Int, Int> > >& clausePbfVarOrder,
-                    vector<Mymap<Pair<Int, Int>, Int, HashFunc, EqualKey>>& itervalToDdIndex,
-                    vector<Dd>& structedDd,
-                    const Int& index,
-                    Int& lf,
-                    Int& rt,
-                    const Int& limit) const;
-    Dd constructDdEq(const vector<Pair<Int, Pair<Int, Int> > >& clausePbfVarOrder,
-                    vector<Map<Int, Int>>& valueToDdIndex,
-                    vector<Dd>& structedDd,
-                    const Int& sufCoefSum,
-                    const Int& index,
-                    const Int& limit) const;
-
-    void abstract(Dd& dd, Int ddVar, const Map<Int, Number> &literalWeights);
+    Dd getConstraintDd(Span<Int> clause, Span<Int> coefficient, PbRelation relation, Int limit) const;
+    Dd getConstraintDd(const PbConstraintStore& constraints, Int constraintIndex) const;
+
     void abstractCube(Dd& dd, const Set<Int>& ddVars, const Map<Int, Number> &literalWeights);
+    void abstractProduct(Dd& dd, const Dd& factor, const Set<Int>& ddVars, const Map<Int, Number> &literalWeights);
+    Dd multiplyAndAbstract(const vector<Dd>& factors, const Set<Int>& ddVars, const Map<Int, Number> &literalWeights);  // ddVars must not occur outside factors; reads productScheduling
+
+    template <typename T>
+    Number extractModelCount(const Dd& dd, const T& projectedCnfVars, const Pbf& pbf) {  // sets laneModelCounts; returns lane 0
+        vector<Number> apparentModelCounts = dd.extractLanes();
+        laneModelCounts.clear();
+        for (Int lane = 0; lane < apparentModelCounts.size(); lane++) {
+            laneModelCounts.push_back(util::adjustModelCount(apparentModelCounts[lane], projectedCnfVars, pbf.getLaneWeights(lane)));
+        }
+        return laneModelCounts.front();
+    }
+    Number countLanesSeparately(const Pbf& pbf);  // without lane leaves, one pass per lane
 
     void printJoinTree(const Pbf& pbf) const;
 
+    vector<vector<Number>> countComponentsInWorkers(const vector<Pbf>& components) const;  // forks componentWorkerCount processes; lanes of each component
+    Number countComponents(const Pbf& pbf);  // product over connected components, each by its own counter
+    void compile(const Pbf& pbf, const string& filePath);  // writes the weight-free conjunction; sets laneModelCounts from it
+
 public:
+    virtual ~Counter() = default;
+    virtual Counter* newCounter() const = 0;  // same heuristics, own diagram manager
+
     virtual void constructJoinTree(const Pbf& pbf) = 0;  // handles cnf without empty clause
     void setJoinTree(const Pbf& pbf);                    // handles cnf with/without empty clause
 
-    Dd countSubtree(JoinNode* joinNode, const Pbf& cnf, Set<Int>& projectedCnfVars);  // handles cnf without empty clause
-    Float countJoinTree(const Pbf& cnf);                                               // handles cnf with/without empty clause
+    Dd countSubtree(JoinNode* joinNode, const Pbf& cnf, Set<Int>& projectedCnfVars);  // handles cnf without empty clause; children are Lace tasks if countingInParallel
+    Number countJoinTree(const Pbf& cnf);                                              // handles cnf with/without empty clause
 
     virtual Number computeModelCount(const Pbf& pbf) = 0;  // handles cnf without empty clause
     Number getModelCount(const Pbf& pbf);                  // handles cnf with/without empty clause
@@ -80,6 +91,7 @@ class MonolithicCounter : public Counter {  // builds an ADD for the entire CNF
    public:
     void constructJoinTree(const Pbf& pbf) override;
     Number computeModelCount(const Pbf& pbf) override;
+    Counter* newCounter() const override;
     MonolithicCounter(VarOrderingHeuristic ddVarOrderingHeuristic, bool inverseDdVarOrdering);
 };
 
@@ -89,12 +101,13 @@ class LinearCounter : public FactoredCounter {  // combines adjacent clauses
    protected:
     vector<Set<Int> > projectableCnfVarSets;  // clauseIndex |-> cnfVars
 
-    void fillProjectableCnfVarSets(const vector<vector<Int>>& clauses);
+    void fillProjectableCnfVarSets(const PbConstraintStore& constraints);
     void setLinearClauseDds(vector<Dd>& clauseDds, const Pbf& pbf);
 
    public:
     void constructJoinTree(const Pbf& pbf) override;
     Number computeModelCount(const Pbf& pbf) override;
+    Counter* newCounter() const override;
     LinearCounter(
         VarOrderingHeuristic ddVarOrderingHeuristic,
         bool inverseDdVarOrdering);
@@ -114,16 +127,17 @@ class NonlinearCounter : public FactoredCounter {  // abstract; puts clauses in
     vector<vector<Dd> > ddClusters;        // clusterIndex |-> ADDs (if usingTreeClustering)
     vector<Set<Int>> projectingDdVarSets;  // clusterIndex |-> ddVars (if usingTreeClustering)
 
-    void printClusters(const vector<vector<Int>>& clauses, const vector<vector<Int>>& coefficient, const vector<string> &options, const vector<Int>& limits) const;
-    void fillClusters(const vector<vector<Int>>& clauses, const vector<Int>& cnfVarOrdering, bool usingMinVar);
+    vector<Int> getCnfVarOrdering(const Pbf& pbf) const;  // prints its induced width if verbosityLevel >= 1
+    void printClusters(const PbConstraintStore& constraints) const;
+    void fillClusters(const PbConstraintStore& constraints, const vector<Int>& cnfVarOrdering, bool usingMinVar);
 
     void printOccurrentCnfVarSets() const;
     void printProjectableCnfVarSets() const;
-    void fillCnfVarSets(const vector<vector<Int>>& clauses, bool usingMinVar);  // writes: occurrentCnfVarSets, projectableCnfVarSets
+    void fillCnfVarSets(const PbConstraintStore& constraints, bool usingMinVar);  // writes: occurrentCnfVarSets, projectableCnfVarSets
 
-    Set<Int> getProjectingDdVars(Int clusterIndex, bool usingMinVar, const vector<Int>& cnfVarOrdering, const vector<vector<Int>>& clauses);
-    void fillDdClusters(const vector<vector<Int>>& clauses, const vector<vector<Int>>& coefficients, const vector<string>& options, const vector<Int>& limits, const vector<Int>& cnfVarOrdering, bool usingMinVar);           // (if usingTreeClustering)
-    void fillProjectingDdVarSets(const vector<vector<Int>>& clauses, const vector<vector<Int>>& coefficients, const vector<string>& options, const vector<Int>& limits, const vector<Int>& cnfVarOrdering, bool usingMinVar);  // (if usingTreeClustering)
+    Set<Int> getProjectingDdVars(Int clusterIndex, bool usingMinVar, const vector<Int>& cnfVarOrdering, const PbConstraintStore& constraints);
+    void fillDdClusters(const PbConstraintStore& constraints, const vector<Int>& cnfVarOrdering, bool usingMinVar);           // (if usingTreeClustering)
+    void fillProjectingDdVarSets(const PbConstraintStore& constraints, const vector<Int>& cnfVarOrdering, bool usingMinVar);  // (if usingTreeClustering)
 
     Int getTargetClusterIndex(Int clusterIndex) const;                                                                  // returns DUMMY_MAX_INT if no var remains
     Int getNewClusterIndex(const Dd& abstractedClusterDd, const vector<Int>& cnfVarOrdering, bool usingMinVar) const;  // returns DUMMY_MAX_INT if no var remains (if usingTreeClustering)
@@ -140,6 +154,7 @@ class BucketCounter : public NonlinearCounter {  // bucket elimination
    public:
     void constructJoinTree(const Pbf& pbf) override;
     Number computeModelCount(const Pbf& pbf) override;
+    Counter* newCounter() const override;
     BucketCounter(
         bool usingTreeClustering,
         VarOrderingHeuristic cnfVarOrderingHeuristic,
@@ -152,6 +167,7 @@ class BouquetCounter : public NonlinearCounter {  // Bouquet's Method
    public:
     void constructJoinTree(const Pbf& pbf) override;
     Number computeModelCount(const Pbf& pbf) override;
+    Counter* newCounter() const override;
     BouquetCounter(
         bool usingTreeClustering,
         VarOrderingHeuristic cnfVarOrderingHeuristic,
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "util.hpp"
+#include "laneLeaf.hpp"
+#include "logLeaf.hpp"
+#include "modular.hpp"
+#include "tieredLeaf.hpp"
 
 /* uses ===================================================================== */
 
@@ -12,10 +16,20 @@ using sylvan::MTBDD;
 using sylvan::mtbdd_apply_CALL;
 using sylvan::mtbdd_fprintdot_nc;
 using sylvan::mtbdd_getdouble;
+using sylvan::mtbdd_gethigh;
+using sylvan::mtbdd_getlow;
+using sylvan::mtbdd_getvar;
 using sylvan::mtbdd_getvalue;
 using sylvan::mtbdd_gmp;
+using sylvan::mtbdd_isleaf;
 using sylvan::mtbdd_leafcount_more;
 using sylvan::mtbdd_makenode;
+using sylvan::mtbdd_op_plus_CALL;
+using sylvan::mtbdd_op_times_CALL;
+using sylvan::mtbdd_refs_pop;
+using sylvan::mtbdd_refs_push;
+using sylvan::mtbdd_refs_spawn;
+using sylvan::mtbdd_refs_sync;
 
 using util::printRow;
 
@@ -41,6 +55,8 @@ class Dd {  // wrapper for CUDD and Sylvan
    public:
     static size_t maxDdLeafCount;
     static size_t maxDdNodeCount;
+    static std::map<string, Pair<size_t, size_t>> maxDdCounts;  // checkpoint |-> (max leaf count, max node count)
+    static std::atomic<Int> parallelRegionCount;               // countSubtree calls whose Lace tasks are not yet synced
 
     static size_t prunedDdCount;
     static Float pruningDuration;
@@ -48,39 +64,48 @@ class Dd {  // wrapper for CUDD and Sylvan
     ADD cuadd;    // CUDD
     Mtbdd mtbdd;  // Sylvan
 
-    size_t getLeafCount() const;
-    size_t getNodeCount() const;
+    size_t getLeafCount() const;   // traverses the diagram
+    size_t getNodeCount() const;   // traverses the diagram
+    void recordCounts(const string& checkpoint) const;  // updates maxDdCounts if verbosityLevel >= 2 and no Lace tasks are running
+    static void printMaxCounts();
 
     Dd(const ADD& cuadd);
     Dd(const Mtbdd& mtbdd);
     Dd(const Dd& dd);
 
-    Number extractConst() const;                             // does not read logCounting
+    Number extractConst() const;                             // log10 of the constant if logCounting; lane 0 if LaneLeaf::isActive
+    vector<Number> extractLanes() const;                     // every lane if LaneLeaf::isActive, else the constant
     static Dd getConstDd(const Number& n, const Cudd& mgr);  // reads logCounting
     static Dd getZeroDd(const Cudd& mgr);                    // returns minus infinity if logCounting
     static Dd getOneDd(const Cudd& mgr);                     // returns zero if logCounting
     static Dd getVarDd(Int ddVar, const Cudd& mgr);
     static Dd getVarDd(Int ddVar, bool val, const Cudd& mgr);
+    static Dd getNode(Int ddVar, const Dd& high, const Dd& low, const Cudd& mgr);  // children must lie below ddVar in the order
     // static const Cudd* newMgr(Float mem, Int threadIndex = 0);  // CUDD
     bool operator!=(const Dd& rightDd) const;
     // bool operator<(const Dd& rightDd) const;                        // *this < rightDd (top of priotity queue is rightmost element)
     Dd getComposition(Int ddVar, bool val, const Cudd& mgr) const;  // restricts *this to ddVar=val
     Dd getProduct(const Dd& dd) const;                              // reads logCounting
-    Dd getSum(const Dd& dd) const;                                  // reads logCounting
+    Dd getSum(const Dd& dd, const Cudd& mgr) const;                 // reads logCounting
     Dd getMax(const Dd& dd) const;                                  // real max (not 0-1 max)
     Dd getXor(const Dd& dd) const;                                  // must be 0-1 DDs
     Dd getIte(Dd& tdd, Dd& fdd) const;                      // if f then tdd else fdd
     Set<Int> getSupport() const;
     Dd getBoolDiff(const Dd& rightDd) const;  // returns 0-1 DD for *this >= rightDd
     bool evalAssignment(vector<int>& ddVarAssignment) const;
-    // Dd getAbstraction(
-    //     Int ddVar,
-    //     const vector<Int>& ddVarToCnfVarMap,
-    //     const Map<Int, Number>& literalWeights,
-    //     const Assignment& assignment,
-    //     bool additiveFlag,  // ? getSum : getMax
-    //     vector<pair<Int, Dd>>& maximizationStack,
-    //     const Cudd* mgr) const;
+    // nodes of a 0-1 Dd, children before parents: node id i + 2 tests nodeDdVars[i], and ids 0 and 1 are the leaves 0 and 1
+    Int getDecisionNodes(vector<Int>& nodeDdVars, vector<Int>& highIds, vector<Int>& lowIds, const Cudd& mgr) const;  // returns the root id
+    Dd getAbstraction(  // sums out all ddVars in one traversal, weighting each branch by its literal weight
+        const Set<Int>& ddVars,
+        const vector<Int>& ddVarToCnfVarMap,
+        const Map<Int, Number>& literalWeights,
+        const Cudd& mgr) const;
+    Dd getProductAbstraction(  // getProduct(dd).getAbstraction(...) without building the full product
+        const Dd& dd,
+        const Set<Int>& ddVars,
+        const vector<Int>& ddVarToCnfVarMap,
+        const Map<Int, Number>& literalWeights,
+        const Cudd& mgr) const;
     // Dd getPrunedDd(Float lowerBound, const Cudd* mgr) const;
 
     Int getTopVar() const;
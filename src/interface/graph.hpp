@@ -12,23 +12,36 @@ using util::printThinLine;
 using util::showError;
 using util::showWarning;
 
+/* types **********************************************************************/
+
+enum class EliminationCost { DEGREE,          // min-degree
+                             FILL,            // min-fill
+                             WEIGHTED_FILL }; // min-fill, each fill edge weighted by the product of its endpoint degrees
+
 /* classes ********************************************************************/
 
-class Graph { // undirected
+// undirected and immutable; vertex ids are 0..n-1 in the order of the vars given to the constructor
+// the neighbors of id v are neighbors[offsets[v] .. offsets[v + 1]), sorted
+class Graph {
 protected:
-  Set<Int> vertices;
-  Map<Int, Set<Int>> adjacencyMap;
+  vector<Int> vertices;  // id |-> var
+  Map<Int, Int> vertexIds; // var |-> id
+  vector<Int> offsets;
+  vector<Int> neighbors;
 
 public:
   void printVertices() const;
   void printAdjacencyMap() const;
-  Graph(const Set<Int> &cnfrVars);
-  void addEdge(Int cnfrVar1, Int cnfrVar2);
-  Set<Int>::const_iterator beginVertices() const;
-  Set<Int>::const_iterator endVertices() const;
-  Set<Int>::const_iterator beginNeighbors(Int cnfrVar);
-  Set<Int>::const_iterator endNeighbors(Int cnfrVar);
-  void removeVertex(Int v); // also removes v's edges
-  bool hasPath(Int from, Int to, Set<Int> &visitedVertices) const;
-  bool hasPath(Int from, Int to) const;
+  Graph(const vector<Int> &vars, const vector<vector<Int>> &cliques); // each clique is a list of vars
+  Int getVertexCount() const;
+  Int getVertex(Int id) const;
+  Int getVertexId(Int var) const;
+  Int getDegree(Int id) const;
+  const Int *beginNeighbors(Int id) const;
+  const Int *endNeighbors(Int id) const;
+  vector<Int> getLexpOrdering() const;
+  vector<Int> getLexmOrdering() const;
+  vector<Int> getMcsOrdering() const; // ties go to the vertex whose count rose last, not to the smaller id
+  vector<Int> getEliminationOrdering(EliminationCost eliminationCost, Int &inducedWidth) const; // greedy, ties broken by smaller id
+  Int getInducedWidth(const vector<Int> &eliminationOrdering) const;         // max neighbor count of an eliminated vertex
 };
@@ -0,0 +1,39 @@
+#pragma once
+
+/* inclusions *****************************************************************/
+
+#include "util.hpp"
+
+/* classes ********************************************************************/
+
+// batched counting: every Sylvan leaf holds laneCount doubles, one per weight vector of the input,
+// so one pass over the diagrams yields all laneCount counts; the all-zero vector is mtbdd_false
+// a leaf value points to laneCount doubles, a length fixed by the input for the whole run
+class LaneLeaf {
+protected:
+    static bool typeInitialized;
+    static Map<Int, vector<Float>> literalLanes;  // literal |-> its weight in every lane
+
+public:
+    static Int laneCount;  // 0 until init
+    static bool isActive() { return laneCount > 0; }
+    static bool isAvailable() { return typeInitialized; }  // Sylvan with double leaves
+
+    static void initLeafType();  // once, after sylvan_init_mtbdd
+    static void init(const vector<Map<Int, Number>>& laneWeights);  // weights of the formula to be counted next
+
+    static sylvan::MTBDD getLeaf(const vector<Float>& lanes);
+    static sylvan::MTBDD getLeaf(Float value);  // value in every lane
+    static const vector<Float>& getLiteralLanes(Int literal);
+    static vector<Float> getLanes(sylvan::MTBDD leaf);  // mtbdd_false is 0 in every lane
+};
+
+/* Lace tasks *****************************************************************/
+
+TASK_DECL_2(sylvan::MTBDD, lane_op_times, sylvan::MTBDD*, sylvan::MTBDD*)
+TASK_DECL_2(sylvan::MTBDD, lane_op_plus, sylvan::MTBDD*, sylvan::MTBDD*)
+TASK_DECL_2(sylvan::MTBDD, lane_op_max, sylvan::MTBDD*, sylvan::MTBDD*)
+
+#define lane_times(a, b) mtbdd_apply(a, b, TASK(lane_op_times))
+#define lane_plus(a, b) mtbdd_apply(a, b, TASK(lane_op_plus))
+#define lane_max(a, b) mtbdd_apply(a, b, TASK(lane_op_max))
@@ -0,0 +1,30 @@
+#pragma once
+
+/* inclusions *****************************************************************/
+
+#include "util.hpp"
+
+/* classes ********************************************************************/
+
+// log-domain counting with Sylvan: a leaf holds the bits of the double log10 of its value, so products add and
+// sums take getLogSumExp; zero is mtbdd_false, never a leaf, so that equal diagrams share one node
+class LogLeaf {
+protected:
+    static uint32_t leafType;
+
+public:
+    static void initLeafType();  // once, after sylvan_init_mtbdd
+
+    static sylvan::MTBDD getLeaf(Float log10Value);
+    static Float getLog10(sylvan::MTBDD leaf);
+};
+
+/* Lace tasks *****************************************************************/
+
+TASK_DECL_2(sylvan::MTBDD, log_op_times, sylvan::MTBDD*, sylvan::MTBDD*)
+TASK_DECL_2(sylvan::MTBDD, log_op_plus, sylvan::MTBDD*, sylvan::MTBDD*)
+TASK_DECL_2(sylvan::MTBDD, log_op_max, sylvan::MTBDD*, sylvan::MTBDD*)
+
+#define log_times(a, b) mtbdd_apply(a, b, TASK(log_op_times))
+#define log_plus(a, b) mtbdd_apply(a, b, TASK(log_op_plus))
+#define log_max(a, b) mtbdd_apply(a, b, TASK(log_op_max))
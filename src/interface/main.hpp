@@ -4,6 +4,7 @@
 
 #include "../../libraries/cxxopts/include/cxxopts.hpp"
 
+#include "compiledDiagram.hpp"
 #include "counter.hpp"
 #include "pbformula.hpp"
 #include "visual.hpp"
@@ -25,6 +26,19 @@ class OptionDict {
     Int multiplePrecisionOption;
     Int maximumMemoryOtion;
     Int preprocessorOption;
+    Int backboneWorkerOption;
+    Float backboneTimeOption;
+    string preprocessPassOption;
+    Int vivifyLiteralOption;
+    Int componentWorkerOption;
+    Int modularCountingOption;
+    Int logCountingOption;
+    Int tieredLeafOption;
+    Int threadCountOption;
+    Int productSchedulingOption;
+    string cacheFileOption;
+    string compileFileOption;
+    string evaluateFileOption;
 
 
     cxxopts::Options* options;
@@ -0,0 +1,44 @@
+#pragma once
+
+/* inclusions *****************************************************************/
+
+#include "util.hpp"
+
+/* classes ********************************************************************/
+
+// exact counting without rationals in the diagrams: every Sylvan leaf holds the residues of its value
+// modulo primeCount primes just below 2^62, in Montgomery form; extractNumber rebuilds the rational by CRT
+// a leaf value points to primeCount + 1 words: primeCount, then one residue per prime
+class ModularField {
+protected:
+    static uint32_t leafType;
+    static vector<uint64_t> primes;
+    static vector<uint64_t> negativeInverses;  // -primes[i]^-1 mod 2^64
+    static vector<uint64_t> montgomerySquares; // 2^128 mod primes[i]
+    static mpz_class denominator;              // the count times denominator is an integer
+    static mpz_class modulus;                  // product of primes
+
+    static mpz_class getInteger(const uint64_t* residues);          // value * denominator by CRT, in (-modulus / 2, modulus / 2]
+
+public:
+    static Int primeCount;  // 0 until init
+    static bool isActive() { return primeCount > 0; }
+
+    static void initLeafType();  // once, after sylvan_init_mtbdd
+    static void init(const Map<Int, Number>& literalWeights);  // picks primeCount from a bound on the count of these weights
+
+    static uint64_t multiply(uint64_t a, uint64_t b, Int primeIndex);  // Montgomery product
+    static uint64_t add(uint64_t a, uint64_t b, Int primeIndex);
+
+    static sylvan::MTBDD getLeaf(const Number& n);
+    static Number getNumber(const uint64_t* words);   // exact only for counts over the weights of the last init
+    static Number extractNumber(sylvan::MTBDD leaf);  // mtbdd_false is 0
+};
+
+/* Lace tasks *****************************************************************/
+
+TASK_DECL_2(sylvan::MTBDD, modular_op_times, sylvan::MTBDD*, sylvan::MTBDD*)
+TASK_DECL_2(sylvan::MTBDD, modular_op_plus, sylvan::MTBDD*, sylvan::MTBDD*)
+
+#define modular_times(a, b) mtbdd_apply(a, b, TASK(modular_op_times))
+#define modular_plus(a, b) mtbdd_apply(a, b, TASK(modular_op_plus))
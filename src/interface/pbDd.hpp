@@ -0,0 +1,36 @@
+#pragma once
+
+/* inclusions *****************************************************************/
+
+#include "ddNode.hpp"
+
+/* classes ********************************************************************/
+
+// builds the DD of one PB constraint with positive coefficients, one node per distinct (level, residual limit) class
+// nodes are made directly with Dd::getNode, so a constraint over n terms with m distinct classes takes O(m log m) work:
+// each level keeps its classes in an ordered map, so finding or adding one costs O(log m)
+class PbDdBuilder {
+protected:
+    struct Interval {  // all residual limits in [lf, rt] give the same sub-diagram
+        Int lf;
+        Int rt;
+        Dd dd;
+    };
+
+    const Cudd& mgr;
+    vector<Pair<Int, Pair<Int, Int> > > terms;  // <ddVar, <literal, coefficient>>, sorted by ddVar
+    vector<Int> suffixCoefSums;                 // suffixCoefSums[i] = sum of the coefficients of terms[i..]
+
+    vector<std::map<Int, Interval> > levelIntervals;  // LEQUAL: disjoint intervals of each level, keyed by lf
+    vector<std::map<Int, Dd> > levelValues;           // EQUAL: residual limit |-> sub-diagram, for each level
+
+    Interval constructLeq(Int index, Int limit);
+    Dd constructEq(Int index, Int limit);
+
+public:
+    PbDdBuilder(const vector<Pair<Int, Pair<Int, Int> > >& terms, const Cudd& mgr);  // terms need not be sorted
+
+    Dd getLeqDd(Int limit);  // sum <= limit
+    Dd getEqDd(Int limit);   // sum = limit
+    Dd getDd(PbRelation relation, Int limit);
+};
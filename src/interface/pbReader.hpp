@@ -0,0 +1,49 @@
+#pragma once
+
+/* inclusions *****************************************************************/
+
+#include <string_view>
+
+#include "util.hpp"
+
+/* classes ********************************************************************/
+
+// the whole input as one read-only char range: a file is memory-mapped when possible, stdin is read in chunks
+class InputBuffer {
+protected:
+    const char* data = nullptr;
+    Int size = 0;
+    void* mappedData = nullptr;  // to be unmapped
+    string ownedData;            // fallback when the input cannot be mapped
+
+    void readStream(std::istream& inputStream);
+
+public:
+    InputBuffer(const string& filePath);  // STDIN_CONVENTION reads stdin
+    ~InputBuffer();
+    InputBuffer(const InputBuffer&) = delete;
+    InputBuffer& operator=(const InputBuffer&) = delete;
+
+    const char* begin() const;
+    const char* end() const;
+    Int getSize() const;
+    bool isMapped() const;
+};
+
+// splits a buffer into lines and whitespace-separated words that point into the buffer
+class LineTokenizer {
+protected:
+    const char* cursor;
+    const char* end;
+
+public:
+    LineTokenizer(const InputBuffer& inputBuffer);
+    bool nextLine(std::string_view& line, vector<std::string_view>& words);  // false at the end of the buffer
+};
+
+/* namespaces *****************************************************************/
+
+namespace util {
+    // like std::stoll: an optional sign then digits, anything after them is ignored
+    Int parseInt(std::string_view word, Int lineIndex);
+}
@@ -4,10 +4,13 @@
 /* inclusions *****************************************************************/
 
 #include "graph.hpp"
+#include "pbReader.hpp"
 
 /* constants ******************************************************************/
 
 extern const string &WEIGHT_WORD;
+extern const string &CACHE_MAGIC;  // first bytes of a binary formula cache
+extern const Int CACHE_VERSION;
 
 /* classes ********************************************************************/
 
@@ -16,16 +19,54 @@ public:
     void addNumber(Int i);
 };
 
+struct PbfCacheKey {  // a cache is read back only for the same input file, weight format and preprocessing
+    Int sourceSize = -1;  // -1 if the input is not a regular file, which is never cached
+    Int sourceModificationTime = 0;  // nanoseconds
+    Int weightFormat = 0;
+    Int preprocessed = 0;
+    Int multiplePrecision = 0;
+};
+
+// constraints in flat arrays: constraint i owns the terms [offsets[i], offsets[i + 1]) of literals and coefficients
+class PbConstraintStore {
+protected:
+    vector<Int> offsets = {0};
+    vector<Int> literals;
+    vector<Int> coefficients;
+    vector<PbRelation> relations;
+    vector<Int> limits;
+
+public:
+    Int size() const;
+    bool empty() const;
+    void add(Span<Int> clause, Span<Int> coefficient, PbRelation relation, Int limit);
+    void assign(vector<Int> offsets, vector<Int> literals, vector<Int> coefficients, vector<PbRelation> relations, vector<Int> limits);
+    void clear();
+
+    Span<Int> getLiterals(Int i) const;
+    Span<Int> getCoefficients(Int i) const;
+    PbRelation getRelation(Int i) const;
+    Int getLimit(Int i) const;
+
+    const vector<Int> &getOffsetArray() const;
+    const vector<Int> &getLiteralArray() const;
+    const vector<Int> &getCoefficientArray() const;
+    const vector<PbRelation> &getRelationArray() const;
+    const vector<Int> &getLimitArray() const;
+
+    Set<Int> getVars(const vector<Int> &constraintIndices) const;
+    void print() const;
+};
+
 class Pbf {
 protected:
     Int declaredVarCount = DUMMY_MAX_INT;
     Int apparentVarCount = DUMMY_MIN_INT;
     WeightFormat weightFormat;
     Map<Int, Number> literalWeights;
-    vector<vector<Int> > clauses;
-    vector<vector<Int> > coefficients;
-    vector<string> options;
-    vector<Int> limits;
+    vector<Map<Int, Number>> laneWeights; // all weight vectors of a batched input (empty if only one); lane 0 equals literalWeights
+    vector<Pair<Int, Int>> substitutions; // (var, literal) of each substituteVar, in order; not cached
+    PbConstraintStore constraints;
     vector<Int> apparentVars; // vars appearing in clauses, ordered by 1st appearance
     
     void updateApparentVars(Int literal); // adds var to apparentVars
@@ -36,32 +77,41 @@ protected:
     vector<Int> getLexpVarOrdering() const;
     vector<Int> getLexmVarOrdering() const;
     vector<Int> getMcsVarOrdering() const;
+    vector<Int> getEliminationVarOrdering(EliminationCost eliminationCost, Int &inducedWidth) const;
 
 public:
-    void addConstraint(const vector<Int> &clause, const vector<Int> &coefficent, const string& option, const Int &limit); // writes: clauses, apparentVars
+    void addConstraint(Span<Int> clause, Span<Int> coefficent, PbRelation relation, Int limit); // writes: constraints, apparentVars
 
     vector<Int> getVarOrdering(VarOrderingHeuristic varOrderingHeuristic, bool inverse) const;
+    vector<Int> getVarOrdering(VarOrderingHeuristic varOrderingHeuristic, bool inverse, Int &inducedWidth) const; // DUMMY_MIN_INT unless the heuristic eliminates
+    Int getInducedWidth(const vector<Int> &varOrdering) const; // of varOrdering taken as an elimination order on the Gaifman graph
     Int getDeclaredVarCount() const;
     Int getApparentVarCount() const;
     Map<Int, Number> getLiteralWeights() const;
+    Int getLaneCount() const; // weight vectors given by the input, each w line listing one weight per lane
+    const Map<Int, Number> &getLaneWeights(Int lane) const;
+    const vector<Map<Int, Number>> &getLaneWeights() const; // empty if only one lane
+    Pbf getLane(Int lane) const;                            // copy with the weights of one lane only
+    const vector<Pair<Int, Int>> &getSubstitutions() const;
     Int getEmptyClauseIndex() const; // first (nonnegative) index if found else DUMMY_MIN_INT
+    vector<Pbf> getComponents() const; // by connected components of the Gaifman graph, each with its vars renumbered from 1
+    Number getUnconstrainedWeight(Int lane = 0) const; // product of w(x) + w(-x) over the vars in no constraint; its log10 if logCounting
 
-    const vector<vector<Int>> &getClauses() const;
-    const vector<vector<Int>> &getCoefficients() const;
-    const vector<string> &getOptions() const;
-    const vector<Int> &getLimits() const;
+    const PbConstraintStore &getConstraints() const;
     const vector<Int> &getApparentVars() const;
 
     // only clear constraint, not weightFormat apparentVars literalWeight 
     void clearConstraints();
-
-    void setClauses(vector<vector<Int> > clauses);
-    void setCoefficients(vector<vector<Int> > coef);
-    void setOptions(vector<string> options);
-    void setLimits(vector<Int> limits);
+    bool substituteVar(Int var, Int literal); // var equals literal in every model; false (and unchanged) if a weight is missing
+    void removeApparentVar(Int var); // for a var left in no constraint, which then counts as unconstrained
 
     void printConstraints() const;
+
+    static PbfCacheKey getCacheKey(const string &filePath, WeightFormat weightFormat); // with the current preprocessorFlag
+    bool readCache(const string &cachePath, const PbfCacheKey &key); // false (and unchanged) unless cachePath holds a matching cache
+    void writeCache(const string &cachePath, const PbfCacheKey &key) const;
+
     void sortConstraintsByOrdering();
+    Pbf(); // empty, to be filled by readCache
     Pbf(const string &filePath, WeightFormat weightFormat);
-    Pbf(const vector<vector<Int>> &clauses, const vector<vector<Int>> &coefficients, const vector<string> & options, const vector<Int> &limits);
 };
\ No newline at end of file
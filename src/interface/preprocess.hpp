@@ -5,6 +5,8 @@
 #include "pbformula.hpp"
 #include "rsInterface.hpp"
 #include "ddNode.hpp"
+#include "pbDd.hpp"
+#include "propagator.hpp"
 
 
 enum class ConstraintRelation { EQUAL,
@@ -16,6 +18,11 @@ enum class ConstraintRelation { EQUAL,
                                 NEQUAL      // A != B
                             };
 
+struct PreprocessPass {    // one entry of preprocessPasses
+    string name;
+    Float timeLimit = 0;    // seconds (0: none)
+};
+
 class Preprocessor {
 protected:
     // formated as      0 < ai * xi <= K
@@ -23,12 +30,13 @@ protected:
     vector<Map<Int, Int> > _coefficients;
     vector<Int>            _upperBound;
     vector<Int>            _lowerBound;
-    vector<string>         _options;
+    vector<PbRelation>     _relations;
 
     vector<Int>            _curCoefSum;
     vector<Int>            _curCoefVal;
 
-    vector<Set<Int> >      _delLiterals;       // literal in constraint.at(i) is deleted, only store positive literal (var)
+    Propagator             _propagator;        // current constraints during vivification, see buildPropagator
+    vector<bool>           _implied;           // constraints found redundant by vivification, erased when it ends
     vector<Int>            _assignVariables;    // variables with 
 
     Int _apparentVarCnt;
@@ -44,10 +52,7 @@ protected:
     void removeTruthConstraints();
 
     inline bool judgeTruthConstraint(Int consIndex) const;
-    inline bool isDelLitFromCons(Int consIndex, Int lit) const { return _delLiterals[consIndex].count(lit) > 0;}
-
-    void delLitFromCons(Int consIndex, Int lit, bool trueAssign);    // delete var from consIndex
-    void rstLitFromCons(Int consIndex, Int lit, bool trueAssign);    // restore var in consIndex
+    void buildPropagator();
    
     void printConstraint(Int consIndex) const;
     void printFormula() const;
@@ -66,8 +71,9 @@ protected:
     void propagateUnitEqConstraint(Int id);
     void propagateSize2EqConstraint(Int id);
 
-    bool propagateLit(Int lit, Int skipConsIndex = -1);
-    bool rstPropagateLit(Int lit, Int skipConsIdex = -1);
+    Int findLiteral(vector<Int>& parents, Int lit) const;    // representative literal of lit's equivalence class
+    void substituteLiterals(const vector<Int>& substitutes);  // var |-> literal replacing it (0: none) in all constraints
+    bool propagateLit(Int lit);     // false on conflict; undo with _propagator.backtrack either way
 
     bool visCnfAssignOnDd(const Dd& dd, Set<Int>& cnfLits, const Int& consIndex);
     bool judgeCnfAssign(const Set<Int>& cnfLits, const Int& consIndex);
@@ -75,29 +81,22 @@ protected:
 
     bool visAndJudgeAssignOnDd(const Dd& dd, const Int& consIndex);
 
-    Dd getConstraintDd(const Set<Int>& clause, const Map<Int, Int>& coefficient, const string& option, const Int& limit) const;
-    Dd constructDd(const vector<Pair<Int, Pair<Int, Int> > >& clausePbfVarOrder,
-                    vector<Mymap<Pair<Int, Int>, Int, HashFunc, EqualKey> >& itervalToDdIndex,
-                    vector<Dd>& structedDd,
-                    const Int& index,
-                    Int& lf,
-                    Int& rt,
-                    const Int& limit) const;
-    Dd constructDdEq(const vector<Pair<Int, Pair<Int, Int> > >& clausePbfVarOrder,
-                    vector<Map<Int, Int> >& valueToDdIndex,
-                    vector<Dd>& structedDd,
-                    const Int& sufCoefSum,
-                    const Int& index,
-                    const Int& limit) const;
+    Dd getConstraintDd(const Set<Int>& clause, const Map<Int, Int>& coefficient, PbRelation relation, Int limit) const;
+
+    Int getLiveVarCount() const;    // vars still occurring in some constraint
+    void writePbf(Pbf &pbf) const;  // replaces the constraints of pbf with the current ones
 
     void output();
 
 public:
     Preprocessor(const Pbf&);
 
-    void doVivif(Pbf &pbf);
-    void doBackBone(Pbf &pbf);
-    void getPreprocessedPbf(Pbf &pbf);
+    static vector<PreprocessPass> getPasses(const string &passList);  // "backbone:5,vivify" etc.
+
+    void doVivif(Pbf &pbf, Float timeLimit = 0);
+    void doBackBone(Pbf &pbf, Float timeLimit = 0);
+    void doProbe(Pbf &pbf, Float timeLimit = 0);
+    void getPreprocessedPbf(Pbf &pbf);  // runs preprocessPasses in order
 
 
     static void test(int, char**);
@@ -0,0 +1,63 @@
+#pragma once
+
+/* inclusions *****************************************************************/
+
+#include "util.hpp"
+
+/* uses ***********************************************************************/
+
+using util::showError;
+
+/* classes ********************************************************************/
+
+// slack-based propagation over constraints  lowerBound <= sum coef_i * lit_i <= upperBound  with every coef_i > 0
+// storage is struct-of-arrays: per constraint slacks, and per var the CSR list of its occurrences; the loops over the
+// occurrences of a var (slack updates, conflict checks, implication filtering) are branch-free
+class Propagator {
+protected:
+    Int varCount = 0;
+
+    // constraint c owns terms [termOffsets[c], termOffsets[c + 1])
+    vector<Int> termOffsets = {0};
+    vector<Int> termLiterals;
+    vector<Int> termCoefficients;
+
+    // per constraint; a negative slack is a conflict, and a term whose coef exceeds a slack is implied
+    vector<Int> upperSlacks;  // upperBound - sum of coefs of true literals
+    vector<Int> lowerSlacks;  // sum of coefs of true and unassigned literals - lowerBound
+    vector<Int> maxCoefficients;
+    vector<char> activeFlags;  // inactive constraints neither conflict nor imply
+
+    // var v occurs at [occurrenceOffsets[v], occurrenceOffsets[v + 1])
+    vector<Int> occurrenceOffsets;
+    vector<Int> occurrenceConstraints;
+    vector<Int> occurrenceCoefficients;
+    vector<char> occurrencePositive;  // 1 if v (not -v) occurs
+
+    vector<signed char> values;      // var |-> 1 (true), -1 (false), 0 (unassigned)
+    vector<Int> trail;               // assigned literals in order
+    Int propagatedCount = 0;         // trail prefix already scanned for implications
+    vector<Int> candidates;          // constraints of one var that may imply a literal, reused by propagate
+
+    void updateSlacks(Int var, bool positive, Int sign);    // sign 1 applies an assignment, -1 undoes it
+    bool hasConflict(Int var) const;                          // over the constraints of var
+    Int findCandidates(Int var);                              // fills candidates; returns how many
+    bool propagateConstraint(Int consIndex);                  // assigns its implied literals
+
+public:
+    Propagator(Int varCount = 0);
+    void addConstraint(Span<Int> literals, Span<Int> coefficients, Int lowerBound, Int upperBound);
+    void buildOccurrences();  // after the last addConstraint
+
+    Int getVarCount() const { return varCount; }
+    Int getConstraintCount() const { return maxCoefficients.size(); }
+    Int getOccurrenceCount(Int var) const { return occurrenceOffsets[var + 1] - occurrenceOffsets[var]; }
+    void setActive(Int consIndex, bool active) { activeFlags[consIndex] = active; }
+    Int getValue(Int lit) const;  // 1, -1 or 0 for the literal lit
+
+    bool assign(Int lit);  // false on conflict; implications are left to propagate
+    bool propagate();      // assigns implied literals until fixpoint; false on conflict
+    Int getTrailSize() const { return trail.size(); }
+    Int getTrailLiteral(Int i) const { return trail[i]; }
+    void backtrack(Int trailSize);  // unassigns the literals after the first trailSize ones
+};
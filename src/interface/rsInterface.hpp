@@ -5,14 +5,23 @@
 #include "../../libraries/roundingsat/src/Solver.hpp"
 
 namespace rsSolver {
-    enum class VarState {UNKNOWN, _TRUE, _FALSE, TRUE, FALSE, UNCERTAIN};  // _TRUE maybe true
+    // one RoundingSat instance loaded with a formula once, then solved repeatedly under assumptions
+    // learned constraints and added units carry over from call to call
+    class IncrementalSolver {
+    protected:
+        rs::Solver solver;
+        Int varCount;
+        bool consistent = true;  // false once the formula itself is unsatisfiable
 
-    extern string getVarState(VarState varState); 
+        bool addConstraint(const rs::CeArb& input);
 
-    extern Int  judgeVarStates(const vector<VarState> &varStates);
-    extern void updateVarStates(vector<VarState> &varStates, const vector<int> &curModel);
-    extern bool tryBackBoneSolve(const Pbf &pbf, const vector<Int> &backBone, const Int lit, vector<Int> &curModel);
-    extern bool getBackBone(const Pbf &pbf, vector<Int> &backBone);
+    public:
+        IncrementalSolver(const Pbf &pbf);
+        bool addUnit(Int lit);  // false if the formula becomes unsatisfiable
+        bool solve(const vector<Int> &assumptions, vector<int> &curModel);  // false if unsatisfiable under assumptions
+    };
+
+    extern bool getBackBone(const Pbf &pbf, vector<Int> &backBone, Float timeLimit = 0);  // false if unsatisfiable
 
     extern bool tryVivifSolve();
     extern bool getVivif(const Pbf& pbf);
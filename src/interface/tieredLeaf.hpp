@@ -0,0 +1,33 @@
+#pragma once
+
+/* inclusions *****************************************************************/
+
+#include "util.hpp"
+
+/* classes ********************************************************************/
+
+// exact Sylvan leaves in the cheapest tier that holds the value, replacing gmp leaves:
+// an integer in [-2^62, 2^62) is stored in the leaf word itself (odd, so never a pointer), a wider one as a heap __int128,
+// then as an mpz, and only a non-integer as an mpq; operations start natively and promote per leaf on overflow
+// every value has exactly one tier, so Sylvan's unique table still identifies equal leaves
+class TieredLeaf {
+protected:
+    static bool active;
+
+public:
+    static void initLeafType();  // once, after sylvan_init_mtbdd; makes isActive true
+    static bool isActive() { return active; }
+
+    static sylvan::MTBDD getLeaf(const mpq_class& q);
+    static mpq_class getQuotient(sylvan::MTBDD leaf);  // mtbdd_false is 0
+};
+
+/* Lace tasks *****************************************************************/
+
+TASK_DECL_2(sylvan::MTBDD, tiered_op_times, sylvan::MTBDD*, sylvan::MTBDD*)
+TASK_DECL_2(sylvan::MTBDD, tiered_op_plus, sylvan::MTBDD*, sylvan::MTBDD*)
+TASK_DECL_2(sylvan::MTBDD, tiered_op_max, sylvan::MTBDD*, sylvan::MTBDD*)
+
+#define tiered_times(a, b) mtbdd_apply(a, b, TASK(tiered_op_times))
+#define tiered_plus(a, b) mtbdd_apply(a, b, TASK(tiered_op_plus))
+#define tiered_max(a, b) mtbdd_apply(a, b, TASK(tiered_op_max))
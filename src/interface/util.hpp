@@ -12,6 +12,7 @@ v               ^
 
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <deque>
 #include <fstream>
@@ -19,6 +20,9 @@ v               ^
 #include <iostream>
 #include <iterator>
 #include <map>
+#include <mutex>
+#include <queue>
+#include <set>
 #include <random>
 #include <sstream>
 #include <unordered_map>
@@ -72,6 +76,18 @@ extern Int maxMem;
 extern Float tableRatio;
 extern Float initRatio;
 extern bool preprocessorFlag;
+extern Int backboneWorkerCount;    // forked RoundingSat processes sharing backbone candidates
+extern Float backboneTimeLimit;     // seconds (0: none); untested candidates are not backbone
+extern Int threadCount;  // Lace workers for Sylvan (0: one per core)
+extern string cacheFilePath;  // binary formula cache (empty: none)
+extern string preprocessPasses;    // comma-separated "pass" or "pass:seconds", run in order
+extern Int vivifyLiteralLimit;     // vivification skips constraints with at least this many literals
+extern Int componentWorkerCount;   // forked processes counting connected components (CUDD Package; Sylvan counts them in turn)
+extern bool modularCounting;       // exact counts from residues modulo word-sized primes (Sylvan Package)
+extern bool logCounting;           // leaves and counts hold log10 values, as doubles
+extern bool tieredLeaves;          // native integer leaves before gmp ones (Sylvan Package with multiplePrecision)
+extern string compileFilePath;     // weight-free diagram of the formula, written instead of counting (empty: none)
+extern string evaluateFilePath;    // compiled diagram, counted with the weights of the input file (empty: none)
 
 // /* constants ******************************************************************/
 extern const Float MEGA;
@@ -106,6 +122,19 @@ extern const string& DIAGRAM_PACKAGE_OPTION;
 extern const string& MULTIPLE_PRECISION_OPTION;
 extern const string& MAXIMUM_MEMORY_OPTION;
 extern const string& PREPROCESSOR_OPTION;
+extern const string& BACKBONE_WORKER_OPTION;
+extern const string& BACKBONE_TIME_OPTION;
+extern const string& THREAD_COUNT_OPTION;
+extern const string& PRODUCT_SCHEDULING_OPTION;
+extern const string& CACHE_FILE_OPTION;
+extern const string& PREPROCESS_PASS_OPTION;
+extern const string& VIVIFY_LITERAL_OPTION;
+extern const string& COMPONENT_WORKER_OPTION;
+extern const string& MODULAR_COUNTING_OPTION;
+extern const string& LOG_COUNTING_OPTION;
+extern const string& TIERED_LEAF_OPTION;
+extern const string& COMPILE_FILE_OPTION;
+extern const string& EVALUATE_FILE_OPTION;
 
 extern const string& CUDD_PACKAGE;
 extern const string& SYLVAN_PACKAGE;
@@ -114,9 +143,21 @@ extern const string DEFAULT_DIAGRAM_PACKAGE;
 extern const Int DEFAULT_MULTIPLE_PRECISION;
 extern const Int DEFAULT_MAXIMUM_MEMORY;
 extern const Int DEFAULT_PREPROCESSOR;
+extern const Int DEFAULT_BACKBONE_WORKER_COUNT;
+extern const Float DEFAULT_BACKBONE_TIME_LIMIT;
+extern const Int DEFAULT_THREAD_COUNT;
+extern const string DEFAULT_PREPROCESS_PASSES;
+extern const Int DEFAULT_VIVIFY_LITERAL_LIMIT;
+extern const Int DEFAULT_COMPONENT_WORKER_COUNT;
+extern const Int DEFAULT_MODULAR_COUNTING;
+extern const Int DEFAULT_LOG_COUNTING;
+extern const Int DEFAULT_TIERED_LEAVES;
 
 enum class WeightFormat { UNWEIGHTED,
                           WEIGHTED };
+
+enum class PbRelation { LEQUAL,  // sum <= limit; >= constraints are negated into this when read
+                        EQUAL }; // sum = limit
 extern const std::map<Int, WeightFormat> WEIGHT_FORMAT_CHOICES;
 extern const Int DEFAULT_WEIGHT_FORMAT_CHOICE;
 
@@ -129,6 +170,12 @@ enum class ClusteringHeuristic { MONOLITHIC,
 extern const std::map<Int, ClusteringHeuristic> CLUSTERING_HEURISTIC_CHOICES;
 extern const Int DEFAULT_CLUSTERING_HEURISTIC_CHOICE;
 
+enum class ProductScheduling { CONSTRAINT_ORDER,  // multiplies factors as given, abstracting with the last product
+                               SMALLEST_FIRST };  // multiplies the two smallest factors, abstracting vars at their last occurrence
+extern const std::map<Int, ProductScheduling> PRODUCT_SCHEDULING_CHOICES;
+extern const Int DEFAULT_PRODUCT_SCHEDULING_CHOICE;
+extern ProductScheduling productScheduling;
+
 enum class VarOrderingHeuristic {
     DUMMY_VAR_ORDERING_HEURISTIC,  // would trigger error in Cnf::getVarOrdering
     APPEARANCE,
@@ -136,7 +183,10 @@ enum class VarOrderingHeuristic {
     RANDOM,
     MCS,
     LEXP,
-    LEXM
+    LEXM,
+    MINFILL,
+    MINDEGREE,
+    WEIGHTED_MINFILL
 };
 extern const std::map<Int, VarOrderingHeuristic> VAR_ORDERING_HEURISTIC_CHOICES;
 extern const Int DEFAULT_CNF_VAR_ORDERING_HEURISTIC_CHOICE;
@@ -182,6 +232,25 @@ class Number {
     Number operator-(const Number& n) const;
 };
 
+template <typename T>
+class Span {  // non-owning view of contiguous elements; vectors convert to it implicitly
+   protected:
+    const T* first = nullptr;
+    const T* last = nullptr;
+
+   public:
+    Span() {}
+    Span(const T* first, const T* last) : first(first), last(last) {}
+    Span(const vector<T>& elements) : first(elements.data()), last(elements.data() + elements.size()) {}
+
+    const T* begin() const { return first; }
+    const T* end() const { return last; }
+    Int size() const { return last - first; }
+    bool empty() const { return first == last; }
+    const T& operator[](Int i) const { return first[i]; }
+    vector<T> toVector() const { return vector<T>(first, last); }
+};
+
 
 /* namespaces *****************************************************************/
 
@@ -210,30 +279,44 @@ namespace util {
     void printMultiplePrecisionOption();
     void printMaximumMemoryOption();
     void printPreprocessorOption();
+    void printBackboneWorkerOption();
+    void printBackboneTimeOption();
+    void printPreprocessPassOption();
+    void printVivifyLiteralOption();
+    void printThreadCountOption();
+    void printComponentWorkerOption();
+    void printModularCountingOption();
+    void printLogCountingOption();
+    void printTieredLeafOption();
+    void printProductSchedulingOption();
+    void printCacheFileOption();
+    void printCompileFileOption();
+    void printEvaluateFileOption();
 
     /* functions: argument parsing **********************************************/
 
     vector<string> getArgV(int argc, char* argv[]);
 
     string getWeightFormatName(WeightFormat weightFormat);
+    string getRelationWord(PbRelation relation);
     string getClusteringHeuristicName(ClusteringHeuristic clusteringHeuristic);
+    string getProductSchedulingName(ProductScheduling productScheduling);
     string getVarOrderingHeuristicName(VarOrderingHeuristic varOrderingHeuristic);
     string getVerbosityLevelName(Int verbosityLevel);
 
     /* functions: CNF ***********************************************************/
 
     Int getCnfVar(Int literal);
-    Set<Int> getClauseCnfVars(const vector<Int>& clause);
-    Set<Int> getClusterCnfVars(const vector<Int>& cluster, const vector<vector<Int>>& clauses);
+    Set<Int> getClauseCnfVars(Span<Int> clause);
 
-    bool appearsIn(Int cnfVar, const vector<Int>& clause);
+    bool appearsIn(Int cnfVar, Span<Int> clause);
     bool isPositiveLiteral(Int literal);
 
     Int getLiteralRank(Int literal, const vector<Int>& cnfVarOrdering);
-    Int getMinClauseRank(const vector<Int>& clause, const vector<Int>& cnfVarOrdering);
-    Int getMaxClauseRank(const vector<Int>& clause, const vector<Int>& cnfVarOrdering);
+    Int getMinClauseRank(Span<Int> clause, const vector<Int>& cnfVarOrdering);
+    Int getMaxClauseRank(Span<Int> clause, const vector<Int>& cnfVarOrdering);
 
-    void printClause(const vector<Int>& clause);
+    void printClause(Span<Int> clause);
     void printCnf(const vector<vector<Int>>& clauses);
     void printLiteralWeights(const Map<Int, Float>& literalWeights);
 
@@ -245,8 +328,7 @@ namespace util {
     void formatConstraint(vector<Int>& clause, vector<Int>& coefficient, Int& limit);
     void inverseConstraint(vector<Int>& clause, vector<Int>& coefficient, Int& limit);
 
-    void printConstraint(const vector<Int>& clause, const vector<Int>& coefficent, const string& option, const Int& limit);
-    void printPbf(const vector<vector<Int>>& clauses, const vector<vector<Int>>& coefficents, const vector<string> &options, const vector<Int>& limits);
+    void printConstraint(Span<Int> clause, Span<Int> coefficent, PbRelation relation, Int limit);
 
     /* functions: timing ********************************************************/
 
@@ -356,11 +438,12 @@ namespace util {
 
         for (Int cnfVar = 1; cnfVar <= totalVarCount; cnfVar++) {
             if (!isFound(cnfVar, projectedCnfVars)) {
-                totalModelCount *= literalWeights.at(cnfVar) + literalWeights.at(-cnfVar);
+                Number weightSum = literalWeights.at(cnfVar) + literalWeights.at(-cnfVar);
+                totalModelCount = logCounting ? Number(totalModelCount.fraction + weightSum.getLog10()) : totalModelCount * weightSum;
             }
         }
 
-        if (totalModelCount == Number()) {
+        if (!logCounting && totalModelCount == Number()) {
             showWarning("floating-point underflow may have occured");
         }
         return totalModelCount;